@@ -5,6 +5,36 @@
  * algorithm to find the min-cut of a graph. It reads a graph in form
  * of an adjacency list from a file specified as the first argument of
  * the program, or prompted for, and writes the result to std output.
+ * The file may also be a binary graph snapshot written by
+ * snapshot/MakeSnapshot, which is loaded without parsing.
+ *
+ * An optional MODE argument after the file name selects the engine:
+ *   map   - the graph is a map of multisets that each trial copies and
+ *           contracts edge by edge (default)
+ *   unionfind
+ *         - the graph is a flat array of edges. Each trial shuffles the
+ *           edges and merges the ends of each edge with union-find until
+ *           two super nodes are left, which is the same as contracting
+ *           random edges; the cut is the number of edges between them
+ *   kargerstein
+ *         - Karger-Stein recursive contraction on the edge array: the
+ *           graph is contracted to about n / sqrt(2) nodes twice,
+ *           independently, and each result is solved recursively, so the
+ *           early contractions, which rarely go wrong, are shared by the
+ *           later ones, which go wrong more often
+ *   stoerwagner
+ *         - the deterministic algorithm of Stoer and Wagner, which always
+ *           finds the min-cut
+ *   bench - runs stoerwagner, unionfind and kargerstein on the graph and
+ *           prints the cut each finds and the time it takes
+ * The unionfind and kargerstein modes take two more optional arguments,
+ * FAILURE and THREADS. The trials are run by THREADS threads (default:
+ * one per core), each with its own random generator. If FAILURE is given
+ * the number of trials is chosen so that the probability that none of
+ * them finds the min-cut is at most FAILURE; otherwise unionfind runs
+ * min(n * n, 200) trials like the map engine and kargerstein runs enough
+ * for a failure probability of 1 / n. The number of trials is written to
+ * std error.
  */
 
 #include <iostream>
@@ -15,16 +45,64 @@
 #include <set>
 #include <stdlib.h>
 #include <algorithm>
+#include <vector>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <math.h>
+#include <limits>
+#include <queue>
+#include <chrono>
+#include "../snapshot/GraphSnapshot.h"
 using namespace std;
 
 typedef multiset<int>::iterator MSetIt;  // aliasing the multiset iterator type used
 typedef map<int, multiset<int> >::iterator MapIt;  // aliasing the map iterator type used
 
+/*
+ * Type: EdgeGraph
+ * ---------------
+ * An undirected multigraph as a flat array of edges. The nodes are
+ * renumbered 0 to nodes - 1 and every edge is stored once.
+ */
+struct EdgeGraph {
+  int nodes;
+  vector<pair<int, int> > edges;
+};
+
+/*
+ * Type: WeightedEdge
+ * ------------------
+ * An edge of the contracted graphs of karger-stein, standing for weight
+ * parallel edges between the super nodes first and second.
+ */
+struct WeightedEdge {
+  int first;
+  int second;
+  int weight;
+};
+
+/*
+ * Type: TrialRunner
+ * -----------------
+ * The state shared by the threads that run the trials. Each thread takes
+ * the next trial from next_trial and keeps its best cut in best[id].
+ */
+struct TrialRunner {
+  EdgeGraph * graph;
+  string engine;
+  int trials;
+  unsigned seed;
+  atomic<int> next_trial;
+  vector<int> best;
+};
+
 /* Function prototypes */
 
 string promptUserForFile(ifstream & infile, string prompt);
 bool testFileName(ifstream & infile, string filename);
 void readFile(map<int, multiset<int> > & mymap, ifstream & infile);
+bool readSnapshot(map<int, multiset<int> > & mymap, string filename);
 void print(map<int, multiset<int> > & mymap);
 
 int mincut(map<int, multiset<int> > mymap);
@@ -32,6 +110,23 @@ int getRandomKey(map<int, multiset<int> > & mymap);
 int getRandomElement(multiset<int> mset);
 void contract(map<int, multiset<int> > & mymap, int node1, int node2);
 
+void toEdgeGraph(map<int, multiset<int> > & mymap, EdgeGraph & graph);
+int mincutUnionFind(EdgeGraph & graph, vector<int> & parent, mt19937 & rng);
+int findRoot(vector<int> & parent, int node);
+int kargerStein(int nodes, vector<WeightedEdge> & edges, mt19937 & rng);
+int contractTo(int nodes, vector<WeightedEdge> & edges, int target, mt19937 & rng, vector<WeightedEdge> & result);
+int bruteForceCut(int nodes, vector<WeightedEdge> & edges);
+bool compareEnds(const WeightedEdge & edge1, const WeightedEdge & edge2);
+int trialCount(string engine, int nodes, double failure);
+int runTrials(EdgeGraph & graph, string engine, int trials, int threads);
+void trialWorker(TrialRunner & runner, int id);
+int stoerWagner(EdgeGraph & graph);
+void benchmark(EdgeGraph & graph, int n);
+int stringToInteger(string str);
+double stringToReal(string str);
+
+const int BRUTE_FORCE_NODES = 6; // graphs karger-stein solves exactly
+
 /* Main program */
 
 using namespace std;
@@ -39,8 +134,16 @@ using namespace std;
 int main(int argc, char* argv[]) {
   map<int, multiset<int> > in_graph;
   ifstream infile;
+  string filename;
+  string mode = argc > 2 ? argv[2] : "map";
+  if (mode != "map" && mode != "unionfind" && mode != "kargerstein" && mode != "stoerwagner" && mode != "bench") {
+    cerr << "Unknown mode: " << mode << "\n"
+	 << "Usage: " << argv[0] << " FILENAME [map|stoerwagner|bench]\n"
+	 << "       " << argv[0] << " FILENAME unionfind|kargerstein [FAILURE [THREADS]]" << endl;
+    return 1;
+  }
   if (argc < 2) {
-    promptUserForFile(infile, "Input file: ");
+    filename = promptUserForFile(infile, "Input file: ");
   }
   else {
     if (!testFileName(infile, argv[1])) {
@@ -48,11 +151,49 @@ int main(int argc, char* argv[]) {
 	   <<"Usage: " << argv[0] << " FILENAME" << endl;
       return 1;
     }
+    filename = argv[1];
+  }
+  if (isSnapshot(filename)) {
+    infile.close();
+    if (!readSnapshot(in_graph, filename)) {
+      cerr << "Unable to read " << filename << endl;
+      return 1;
+    }
+  } else {
+    readFile(in_graph, infile);
   }
-  readFile(in_graph, infile);
   int n = in_graph.size();;
   int min_k = n;
   int k; // size of min-cut set
+  if (mode == "stoerwagner" || mode == "bench") {
+    EdgeGraph graph;
+    toEdgeGraph(in_graph, graph);
+    if (mode == "bench") benchmark(graph, n);
+    else cout << "Min-cut size: " << stoerWagner(graph) << endl;
+    return 0;
+  }
+  if (mode == "unionfind" || mode == "kargerstein") {
+    EdgeGraph graph;
+    toEdgeGraph(in_graph, graph);
+    int trials;
+    if (argc > 3) {
+      double failure = stringToReal(argv[3]);
+      if (failure <= 0 || failure >= 1) {
+	cerr << "FAILURE must be between 0 and 1" << endl;
+	return 1;
+      }
+      trials = trialCount(mode, graph.nodes, failure);
+    } else if (mode == "unionfind") {
+      trials = min(n * n, 200);
+    } else {
+      trials = trialCount(mode, graph.nodes, 1.0 / max(n, 2));
+    }
+    int threads = argc > 4 ? stringToInteger(argv[4]) : thread::hardware_concurrency();
+    threads = max(min(threads, trials), 1);
+    cerr << "trials: " << trials << " threads: " << threads << endl;
+    cout << "Min-cut size: " << runTrials(graph, mode, trials, threads) << endl;
+    return 0;
+  }
   srand(time(NULL));
   for (int i = 0; i < min(n * n, 200); i++) {
     k = mincut(in_graph);
@@ -135,6 +276,363 @@ void contract(map<int, multiset<int> > & mymap, int node1, int node2) {
   mymap[node1].erase(ret.first, ret.second);
 }
 
+/*
+ * Function: toEdgeGraph
+ * Usage: EdgeGraph graph; toEdgeGraph(mymap, graph);
+ * --------------------------------------------------
+ * Converts the adjacency lists into a flat edge array. Each edge is listed
+ * in the rows of both its ends, so only the copy from the row of the
+ * smaller node is kept; parallel edges stay separate edges.
+ */
+void toEdgeGraph(map<int, multiset<int> > & mymap, EdgeGraph & graph) {
+  map<int, int> index;
+  for (MapIt it = mymap.begin(); it != mymap.end(); ++it) {
+    int id = index.size();
+    index[it -> first] = id;
+  }
+  graph.nodes = index.size();
+  graph.edges.clear();
+  for (MapIt it = mymap.begin(); it != mymap.end(); ++it) {
+    for (MSetIt it2 = it -> second.begin(); it2 != it -> second.end(); ++it2) {
+      if (it -> first < *it2 && index.count(*it2)) {
+	graph.edges.push_back(make_pair(index[it -> first], index[*it2]));
+      }
+    }
+  }
+}
+
+/*
+ * Function: mincutUnionFind
+ * Usage: int k = mincutUnionFind(graph, parent, rng);
+ * ---------------------------------------------------
+ * One trial of the random contraction algorithm with union-find:
+ * - shuffle the edges, which contracts them in a uniformly random order
+ * - walk the edges and merge the super nodes of their ends, skipping
+ *   edges inside a super node (the self-loops of the contracted graph),
+ *   until only 2 super nodes remain
+ * - return the number of edges between the 2 super nodes
+ * This takes O(m alpha(n)) time. parent is the union-find forest, reset
+ * by every trial; the edge array is shuffled in place.
+ */
+int mincutUnionFind(EdgeGraph & graph, vector<int> & parent, mt19937 & rng) {
+  for (int v = 0; v < graph.nodes; v++) parent[v] = v;
+  shuffle(graph.edges.begin(), graph.edges.end(), rng);
+  int remaining = graph.nodes;
+  for (size_t e = 0; e < graph.edges.size() && remaining > 2; e++) {
+    int root1 = findRoot(parent, graph.edges[e].first);
+    int root2 = findRoot(parent, graph.edges[e].second);
+    if (root1 == root2) continue;
+    parent[root2] = root1;
+    remaining--;
+  }
+  int cut = 0;
+  for (size_t e = 0; e < graph.edges.size(); e++) {
+    if (findRoot(parent, graph.edges[e].first) != findRoot(parent, graph.edges[e].second)) cut++;
+  }
+  return cut;
+}
+
+/*
+ * Function: kargerStein
+ * Usage: int k = kargerStein(nodes, edges, rng);
+ * ----------------------------------------------
+ * One run of the recursive contraction algorithm of Karger and Stein on
+ * a multigraph with nodes 0 to nodes - 1:
+ * - graphs with at most BRUTE_FORCE_NODES nodes are solved exactly
+ * - otherwise contract the graph to t = ceil(1 + nodes / sqrt(2)) nodes
+ *   twice, independently, and return the smaller of the cuts the two
+ *   recursive calls find
+ * A run succeeds with probability about 1 / log2(n), against 2 / n^2 for
+ * a single contraction. Parallel edges are kept as one weighted edge, so
+ * a graph with t nodes has at most t^2 / 2 edges and a run takes
+ * O(n^2 log n) time.
+ */
+int kargerStein(int nodes, vector<WeightedEdge> & edges, mt19937 & rng) {
+  if (edges.empty()) return 0;
+  if (nodes <= BRUTE_FORCE_NODES) return bruteForceCut(nodes, edges);
+  int target = (int) ceil(1 + nodes / sqrt(2.0));
+  int best = numeric_limits<int>::max();
+  for (int i = 0; i < 2; i++) {
+    vector<WeightedEdge> contracted;
+    int remaining = contractTo(nodes, edges, target, rng, contracted);
+    best = min(best, kargerStein(remaining, contracted, rng));
+  }
+  return best;
+}
+
+/*
+ * Function: contractTo
+ * Usage: int n = contractTo(nodes, edges, target, rng, result);
+ * -------------------------------------------------------------
+ * Contracts random edges with union-find until target super nodes are
+ * left, or the edges run out. Picking a random one of the parallel edges
+ * that are left, one at a time, orders the weighted edges like random
+ * keys drawn from an exponential distribution with the weight as rate,
+ * so the edges are contracted in the order of such keys. Returns the
+ * number of super nodes and the weighted edges between them in result,
+ * with the super nodes renumbered from 0.
+ */
+int contractTo(int nodes, vector<WeightedEdge> & edges, int target, mt19937 & rng, vector<WeightedEdge> & result) {
+  exponential_distribution<double> exponential;
+  vector<pair<double, int> > keys(edges.size());
+  for (size_t e = 0; e < edges.size(); e++) keys[e] = make_pair(exponential(rng) / edges[e].weight, e);
+  sort(keys.begin(), keys.end());
+  vector<int> parent(nodes);
+  for (int v = 0; v < nodes; v++) parent[v] = v;
+  int remaining = nodes;
+  for (size_t k = 0; k < keys.size() && remaining > target; k++) {
+    int root1 = findRoot(parent, edges[keys[k].second].first);
+    int root2 = findRoot(parent, edges[keys[k].second].second);
+    if (root1 == root2) continue;
+    parent[root2] = root1;
+    remaining--;
+  }
+  vector<int> number(nodes, -1);
+  int count = 0;
+  for (int v = 0; v < nodes; v++) {
+    if (parent[v] == v) number[v] = count++;
+  }
+  result.clear();
+  for (size_t e = 0; e < edges.size(); e++) {
+    int end1 = number[findRoot(parent, edges[e].first)];
+    int end2 = number[findRoot(parent, edges[e].second)];
+    if (end1 == end2) continue;
+    WeightedEdge edge = { min(end1, end2), max(end1, end2), edges[e].weight };
+    result.push_back(edge);
+  }
+  sort(result.begin(), result.end(), compareEnds);
+  size_t kept = 0;
+  for (size_t e = 0; e < result.size(); e++) {
+    if (kept > 0 && result[kept - 1].first == result[e].first && result[kept - 1].second == result[e].second) {
+      result[kept - 1].weight += result[e].weight;
+    } else {
+      result[kept++] = result[e];
+    }
+  }
+  result.resize(kept);
+  return count;
+}
+
+bool compareEnds(const WeightedEdge & edge1, const WeightedEdge & edge2) {
+  return edge1.first < edge2.first || (edge1.first == edge2.first && edge1.second < edge2.second);
+}
+
+/*
+ * Function: bruteForceCut
+ * Usage: int k = bruteForceCut(nodes, edges);
+ * -------------------------------------------
+ * Returns the min-cut of a small graph by trying every split of the
+ * nodes into two non-empty sides; node nodes - 1 always stays on the
+ * second side so each cut is counted once.
+ */
+int bruteForceCut(int nodes, vector<WeightedEdge> & edges) {
+  int best = numeric_limits<int>::max();
+  for (int side = 1; side < (1 << (nodes - 1)); side++) {
+    int cut = 0;
+    for (size_t e = 0; e < edges.size(); e++) {
+      if (((side >> edges[e].first) & 1) != ((side >> edges[e].second) & 1)) cut += edges[e].weight;
+    }
+    best = min(best, cut);
+  }
+  return best;
+}
+
+/*
+ * Function: stoerWagner
+ * Usage: int k = stoerWagner(graph);
+ * ----------------------------------
+ * The min-cut algorithm of Stoer and Wagner. Each phase adds the super
+ * nodes one at a time to a growing set A, always taking the one most
+ * tightly connected to A (maximum adjacency order). The edges between the
+ * last node added and the rest form a cut that is minimal among the cuts
+ * separating the last two nodes, which are then merged. After n - 1
+ * phases the smallest of these cuts is the min-cut.
+ * The connection weights to A are kept in a binary max-heap with lazy
+ * deletion, so a phase takes O(m log m) time. Merged nodes are tracked
+ * with union-find: the adjacency lists may still name merged nodes and
+ * are resolved with findRoot when they are read; the list of the merged
+ * node itself is resolved and compacted right away.
+ */
+int stoerWagner(EdgeGraph & graph) {
+  int nodes = graph.nodes;
+  if (nodes < 2) return 0;
+  vector<vector<pair<int, int> > > adjacent(nodes); // (node, weight)
+  for (size_t e = 0; e < graph.edges.size(); e++) {
+    adjacent[graph.edges[e].first].push_back(make_pair(graph.edges[e].second, 1));
+    adjacent[graph.edges[e].second].push_back(make_pair(graph.edges[e].first, 1));
+  }
+  vector<int> parent(nodes);
+  for (int v = 0; v < nodes; v++) parent[v] = v;
+  vector<long long> key(nodes);
+  vector<int> added(nodes, -1); // phase in which a node joined A
+  long long best = numeric_limits<long long>::max();
+  for (int phase = 0; phase < nodes - 1; phase++) {
+    int active = nodes - phase;
+    priority_queue<pair<long long, int> > heap;
+    int start = -1;
+    for (int v = 0; v < nodes; v++) {
+      if (parent[v] != v) continue;
+      key[v] = 0;
+      if (start == -1) start = v;
+    }
+    heap.push(make_pair(0LL, start));
+    int previous = -1, last = -1;
+    long long cut = 0;
+    for (int count = 0; count < active; ) {
+      int node;
+      if (heap.empty()) { // disconnected graph: continue with any node
+	node = -1;
+	for (int v = 0; v < nodes && node == -1; v++) {
+	  if (parent[v] == v && added[v] != phase) node = v;
+	}
+      } else {
+	pair<long long, int> top = heap.top();
+	heap.pop();
+	node = top.second;
+	if (added[node] == phase || top.first != key[node]) continue;
+      }
+      added[node] = phase;
+      count++;
+      previous = last;
+      last = node;
+      cut = key[node];
+      for (size_t i = 0; i < adjacent[node].size(); i++) {
+	int next = findRoot(parent, adjacent[node][i].first);
+	if (next == node || added[next] == phase) continue;
+	key[next] += adjacent[node][i].second;
+	heap.push(make_pair(key[next], next));
+      }
+    }
+    best = min(best, cut);
+    // merge last into previous
+    parent[last] = previous;
+    vector<pair<int, int> > & merged = adjacent[previous];
+    merged.insert(merged.end(), adjacent[last].begin(), adjacent[last].end());
+    vector<pair<int, int> >().swap(adjacent[last]);
+    for (size_t i = 0; i < merged.size(); i++) merged[i].first = findRoot(parent, merged[i].first);
+    sort(merged.begin(), merged.end());
+    size_t kept = 0;
+    for (size_t i = 0; i < merged.size(); i++) {
+      if (merged[i].first == previous) continue;
+      if (kept > 0 && merged[kept - 1].first == merged[i].first) merged[kept - 1].second += merged[i].second;
+      else merged[kept++] = merged[i];
+    }
+    merged.resize(kept);
+  }
+  return best;
+}
+
+/*
+ * Function: benchmark
+ * Usage: benchmark(graph, n);
+ * ---------------------------
+ * Runs stoerwagner, unionfind (with the min(n * n, 200) trials of the
+ * map engine) and kargerstein (for a failure probability of 1 / n) on the
+ * graph with one thread per core and prints the cut each finds and the
+ * time it takes, not counting the time to read the file.
+ */
+void benchmark(EdgeGraph & graph, int n) {
+  typedef chrono::steady_clock Clock;
+  int threads = max((int) thread::hardware_concurrency(), 1);
+  cout << "nodes: " << graph.nodes << " edges: " << graph.edges.size() << " threads: " << threads << endl;
+  Clock::time_point start = Clock::now();
+  int exact = stoerWagner(graph);
+  double time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "stoerwagner: cut " << exact << ", " << time << " s" << endl;
+  string engines[] = {"unionfind", "kargerstein"};
+  for (int i = 0; i < 2; i++) {
+    int trials = i == 0 ? min(n * n, 200) : trialCount(engines[i], graph.nodes, 1.0 / max(n, 2));
+    start = Clock::now();
+    int cut = runTrials(graph, engines[i], trials, min(threads, trials));
+    time = chrono::duration<double>(Clock::now() - start).count();
+    cout << engines[i] << ": cut " << cut << ", " << time << " s (" << trials << " trials)"
+	 << (cut == exact ? "" : " MISSED") << endl;
+  }
+}
+
+/*
+ * Function: trialCount
+ * Usage: int trials = trialCount(engine, nodes, failure);
+ * -------------------------------------------------------
+ * Returns the number of independent trials after which the probability
+ * that none found the min-cut is at most failure, based on the success
+ * probability p of one trial of the engine: 2 / (n (n - 1)) for random
+ * contraction and 1 / (log2(n) + 1) for Karger-Stein. With k trials the
+ * failure probability is (1 - p)^k.
+ */
+int trialCount(string engine, int nodes, double failure) {
+  if (nodes < 3) return 1;
+  double success = engine == "unionfind" ? 2.0 / ((double) nodes * (nodes - 1)) : 1.0 / (log2((double) nodes) + 1);
+  double trials = ceil(log(failure) / log1p(-success));
+  return (int) min(trials, 2e9);
+}
+
+/*
+ * Function: runTrials
+ * Usage: int k = runTrials(graph, engine, trials, threads);
+ * ---------------------------------------------------------
+ * Runs trials trials of the engine on threads threads and returns the
+ * smallest cut found. The threads seed their random generators from one
+ * random seed and their thread number, so no two share a sequence.
+ */
+int runTrials(EdgeGraph & graph, string engine, int trials, int threads) {
+  TrialRunner runner;
+  runner.graph = &graph;
+  runner.engine = engine;
+  runner.trials = trials;
+  runner.seed = random_device()() ^ (unsigned) time(NULL);
+  runner.next_trial.store(0);
+  runner.best.assign(threads, graph.edges.size());
+  vector<thread> workers;
+  for (int i = 1; i < threads; i++) workers.push_back(thread(trialWorker, ref(runner), i));
+  trialWorker(runner, 0);
+  for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+  return *min_element(runner.best.begin(), runner.best.end());
+}
+
+/*
+ * Function: trialWorker
+ * Usage: thread(trialWorker, ref(runner), id);
+ * --------------------------------------------
+ * Runs trials until all are taken. The unionfind engine shuffles the edge
+ * array in place, so each thread works on its own copy; karger-stein
+ * gets the edges with weight 1.
+ */
+void trialWorker(TrialRunner & runner, int id) {
+  seed_seq seeds = {runner.seed, (unsigned) id};
+  mt19937 rng(seeds);
+  EdgeGraph graph = *runner.graph;
+  vector<int> parent(graph.nodes);
+  vector<WeightedEdge> weighted;
+  if (runner.engine == "kargerstein") {
+    for (size_t e = 0; e < graph.edges.size(); e++) {
+      WeightedEdge edge = { graph.edges[e].first, graph.edges[e].second, 1 };
+      weighted.push_back(edge);
+    }
+  }
+  int best = runner.best[id];
+  while (runner.next_trial.fetch_add(1) < runner.trials) {
+    if (runner.engine == "unionfind") best = min(best, mincutUnionFind(graph, parent, rng));
+    else best = min(best, kargerStein(graph.nodes, weighted, rng));
+  }
+  runner.best[id] = best;
+}
+
+/*
+ * Function: findRoot
+ * Usage: int root = findRoot(parent, node);
+ * -----------------------------------------
+ * Returns the root of the union-find tree of node, halving the path to
+ * it on the way.
+ */
+int findRoot(vector<int> & parent, int node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
+  }
+  return node;
+}
+
 /*
  * Function: readFile
  * Usage: map<int, multiset> graph; readFile(graph);
@@ -157,6 +655,27 @@ void readFile(map<int, multiset<int> > & mymap, ifstream & infile) {
   infile.close();
 }
 
+/*
+ * Function: readSnapshot
+ * Usage: map<int, multiset> graph; readSnapshot(graph, filename);
+ * ---------------------------------------------------------------
+ * Reads the adjacency lists from a graph snapshot instead of a text
+ * file. Returns false if the file is not a valid snapshot.
+ */
+bool readSnapshot(map<int, multiset<int> > & mymap, string filename) {
+  GraphSnapshot snapshot;
+  if (!openSnapshot(snapshot, filename)) return false;
+  for (long long v = 0; v < snapshot.nodes; v++) {
+    if (!snapshot.present[v]) continue;
+    multiset<int> & mset = mymap[v];
+    for (long long e = snapshot.offsets[v]; e < snapshot.offsets[v + 1]; e++) {
+      mset.insert(snapshot.targets[e]);
+    }
+  }
+  closeSnapshot(snapshot);
+  return true;
+}
+
 /*
  * Function: print
  * Usage: vector<int> vec; print(vec);
@@ -202,3 +721,25 @@ bool testFileName(ifstream & infile, string filename) {
   infile.open(filename.c_str());
   return !infile.fail();
 }
+
+int stringToInteger(string str) {
+  istringstream stream(str);
+  int value;
+  stream >> value;
+  if (stream.fail() || !(stream >> ws).eof()) {
+    cerr << "stringToInteger: Illegal integer format (" + str + ")";
+    return 1;
+  }
+  return value;
+}
+
+double stringToReal(string str) {
+  istringstream stream(str);
+  double value;
+  stream >> value;
+  if (stream.fail() || !(stream >> ws).eof()) {
+    cerr << "stringToReal: Illegal real format (" + str + ")";
+    return 1;
+  }
+  return value;
+}
@@ -18,6 +18,9 @@
  * or it will be prompted for by the program.
  * The priogram writes the result to std output. It outputs the vertices
  * and the shortest path distances to these vertices.
+ * An optional comma separated list of TARGETS after the file name
+ * restricts the output to these vertices, and the search stops as soon
+ * as all of them have been processed.
  */
 
 #include <iostream>
@@ -37,7 +40,6 @@ using namespace std;
 typedef set<pair <int, int> >::iterator SetIterator;  // aliasing the set iterator type used
 typedef set<int>::iterator SetIntIterator;  // aliasing the set with int iterator type used
 typedef map<int, set<pair <int, int> > >::iterator MapIterator;  // aliasing the map iterator type used
-typedef map<int, list<int> >::iterator MapListIterator;  // aliasing the map list iterator type used
 typedef map<int, int>::iterator MapIntIterator;  // aliasing the map int iterator type used
 typedef list<int>::iterator ListIterator;  // aliasing the set iterator type used
 
@@ -48,11 +50,14 @@ bool testFileName(ifstream & infile, string filename);
 void readFile(map<int, set<pair<int, int> > > & graph, ifstream & infile);
 void print(map<int, set<pair<int, int> > > & graph);
 void print(map<int, int> & distances);
-void print(map<int, list<int> > & pathmap);
-void print(map<int, int> & distances, map<int, list<int> > & pathmap);
+void print(map<int, int> & distances, vector<int> & predecessors);
+void print(map<int, int> & distances, vector<int> & predecessors, vector<int> & targets);
+void print(int node, int distance, vector<int> & predecessors);
+list<int> getPath(vector<int> & predecessors, int node);
 int stringToInteger(string str);
+bool readTargets(vector<int> & targets, string str);
 
-void mainloop(map<int, set<pair<int, int> > > & graph, set<int> & processed, map<int, int> & distances, map<int, list<int> > & pathmap);
+void mainloop(map<int, set<pair<int, int> > > & graph, set<int> & processed, map<int, int> & distances, vector<int> & predecessors, vector<int> & targets);
 
 int sourceNode, maxNodes;
 const int MAX_DIST = 1000000;
@@ -67,12 +72,16 @@ int main(int argc, char* argv[]) {
 
   if (argc < 3) {
     cerr << "Invalid number of arguments\n"
-	 <<"Usage: " << argv[0] << " SOURCE_NODE MAX_NODES [FILENAME]" << endl;
+	 <<"Usage: " << argv[0] << " SOURCE_NODE MAX_NODES [FILENAME [TARGETS]]" << endl;
     return 1;
   } else {
     sourceNode = stringToInteger(argv[1]);
     maxNodes = stringToInteger(argv[2]);
   }
+  if (sourceNode < 0 || sourceNode > maxNodes) {
+    cerr << "Invalid source node: " << sourceNode << " (max nodes: " << maxNodes << ")" << endl;
+    return 1;
+  }
   if (argc < 4) {
     promptUserForFile(infile, "Input file: ");
   }
@@ -84,6 +93,11 @@ int main(int argc, char* argv[]) {
     }
   }
   // cout << "start: " << sourceNode << " max nodes: " << maxNodes << endl;
+  vector<int> targets;
+  if (argc > 4 && !readTargets(targets, argv[4])) {
+    cerr << "Usage: " << argv[0] << " SOURCE_NODE MAX_NODES [FILENAME [TARGETS]]" << endl;
+    return 1;
+  }
 
   /*
    * graph is a map with vertices as keys pointing to a
@@ -108,21 +122,24 @@ int main(int argc, char* argv[]) {
   }
 
   /*
-   * pathmap is a map containing all shortest paths.
-   * the key is the node and each element is a list
-   * with the shortest path nodes for the key node.
+   * predecessors contains the shortest path tree. The element
+   * for a node is the node before it on its shortest path, or -1
+   * for the source node and for nodes not reached. The paths are
+   * only built from it when they are printed.
    */
-  map<int, list<int> > pathmap;
+  vector<int> predecessors(maxNodes + 1, -1);
 
   distances[sourceNode] = 0; // set distance to source node equal to zero
-  pathmap[sourceNode]; // set shortest path for source node to empty set
 
   // lets start
-  mainloop(graph, processed, distances, pathmap);
+  mainloop(graph, processed, distances, predecessors, targets);
 
   // print(distances);
-  // print(pathmap);
-  print(distances, pathmap);
+  if (targets.empty()) {
+    print(distances, predecessors);
+  } else {
+    print(distances, predecessors, targets);
+  }
 
   return 0;
 }
@@ -134,9 +151,15 @@ int main(int argc, char* argv[]) {
  * according to Dijkstra's greedy criterion,
  * adding the processed node to the processed array
  * until there are no more nodes to process.
+ * If targets is not empty, it stops when all targets are processed.
  */
-void mainloop(map<int, set<pair<int, int> > > & graph, set<int> & processed, map<int, int> & distances, map<int, list<int> > & pathmap) {
+void mainloop(map<int, set<pair<int, int> > > & graph, set<int> & processed, map<int, int> & distances, vector<int> & predecessors, vector<int> & targets) {
   int graph_size = graph.size();
+  set<int> remaining(targets.begin(), targets.end()); // targets not processed yet
+  for (SetIntIterator it = processed.begin(); it != processed.end(); ++it) {
+    remaining.erase(*it);
+  }
+  if (!targets.empty() && remaining.empty()) return;
   int x_node_path, edge_node, edge_length;
   int min_x_node, min_edge, min_edge_length, greedy_score;
   set<pair <int, int> > target_nodes;
@@ -163,12 +186,14 @@ void mainloop(map<int, set<pair<int, int> > > & graph, set<int> & processed, map
 	}
       }
     }
+    if (min_edge_length == MAX_DIST) break; // the remaining nodes are not reachable
     processed.insert(min_edge);
     //cout << "min_edge = " << min_edge << endl;
     distances[min_edge] = min_edge_length;
     //cout << "min_edge_length = " << min_edge_length << endl;
-    pathmap[min_edge] = pathmap[min_x_node];
-    pathmap[min_edge].push_back(min_edge);
+    predecessors[min_edge] = min_x_node;
+    remaining.erase(min_edge);
+    if (!targets.empty() && remaining.empty()) break; // early exit
   }
 }
 
@@ -234,31 +259,78 @@ void print(map<int, int> & distances) {
   }
 }
 
-void print(map<int, list<int> > & pathmap) {
-  list<int> mlist;
-  for (MapListIterator it = pathmap.begin(); it != pathmap.end(); ++it) {
-    mlist = it -> second;
-    cout << it -> first << " => [";
-    for (ListIterator it2 = mlist.begin(); it2 != mlist.end(); ++it2) {
-      cout << *it2 << ", ";
+void print(map<int, int> & distances, vector<int> & predecessors) {
+  for (MapIntIterator it = distances.begin(); it != distances.end(); ++it) {
+    print(it -> first, it -> second, predecessors);
+  }
+}
+
+void print(map<int, int> & distances, vector<int> & predecessors, vector<int> & targets) {
+  for (size_t i = 0; i < targets.size(); i++) {
+    MapIntIterator it = distances.find(targets[i]);
+    if (it == distances.end()) {
+      cout << "Warning: node " << targets[i] << " is not in the graph" << endl;
+    } else {
+      print(it -> first, it -> second, predecessors);
     }
-    cout << "]" << endl;
   }
 }
 
-void print(map<int, int> & distances, map<int, list<int> > & pathmap) {
-  list<int> mlist;
-  int mnode, path_length; 
-  for (MapIntIterator it = distances.begin(); it != distances.end(); ++it) {
-    mnode = it -> first;
-    path_length = it -> second;
-    mlist = pathmap[mnode];
-    cout << mnode << " => " << path_length << " [";
-    for (ListIterator it2 = mlist.begin(); it2 != mlist.end(); ++it2) {
-      cout << *it2 << ", ";
+/*
+ * Function: print
+ * Usage: print(node, distance, predecessors);
+ * -------------------------------------------
+ * Prints one node with its shortest path distance and its shortest
+ * path, which is reconstructed from the predecessors.
+ */
+void print(int node, int distance, vector<int> & predecessors) {
+  list<int> mlist = getPath(predecessors, node);
+  cout << node << " => " << distance << " [";
+  for (ListIterator it = mlist.begin(); it != mlist.end(); ++it) {
+    cout << *it << ", ";
+  }
+  cout << "]" << endl;
+}
+
+/*
+ * Function: getPath
+ * Usage: list<int> path = getPath(predecessors, node);
+ * ----------------------------------------------------
+ * Returns the nodes of the shortest path to node, excluding the source
+ * node, by following the predecessors back to the source. The path is
+ * empty for the source node and for nodes that were not reached.
+ */
+list<int> getPath(vector<int> & predecessors, int node) {
+  list<int> path;
+  while (predecessors[node] != -1) {
+    path.push_front(node);
+    node = predecessors[node];
+  }
+  return path;
+}
+
+/*
+ * Function: readTargets
+ * Usage: vector<int> targets; readTargets(targets, "7,37,59");
+ * ------------------------------------------------------------
+ * Reads a comma separated list of node numbers into targets. Returns
+ * false, after reporting the token, if one is not a number or not in
+ * 0 .. maxNodes, like the source node.
+ */
+bool readTargets(vector<int> & targets, string str) {
+  istringstream stream(str);
+  string node;
+  while (getline(stream, node, ',')) {
+    istringstream token(node);
+    int target;
+    token >> target;
+    if (token.fail() || !(token >> ws).eof() || target < 0 || target > maxNodes) {
+      cerr << "Invalid target node: " << node << " (max nodes: " << maxNodes << ")" << endl;
+      return false;
     }
-    cout << "]" << endl;
+    targets.push_back(target);
   }
+  return true;
 }
 
 /*
@@ -292,8 +364,8 @@ bool testFileName(ifstream & infile, string filename) {
 int stringToInteger(string str) {
   istringstream stream(str);
   int value;
-  stream >> value >> ws;
-  if (stream.fail() || !stream.eof()) {
+  stream >> value;
+  if (stream.fail() || !(stream >> ws).eof()) {
     cerr << "stringToInteger: Illegal integer format (" + str + ")";
     return 1;
   }
@@ -18,6 +18,62 @@
  * or it will be prompted for by the program.
  * The priogram writes the result to std output. It outputs the vertices
  * and the shortest path distances to these vertices.
+ *
+ * An optional MODE argument after the file name selects the engine:
+ *   heap  - the graph is a map of sets and the heap uses a map from
+ *           node to heap index (default)
+ *   csr   - the graph is stored in compressed sparse row form and the
+ *           heap uses a vector indexed by node number with an in-place
+ *           decrease-key, which scales to tens of millions of edges
+ *   radix - CSR graph with a monotone radix heap as priority queue
+ *   dial  - CSR graph with Dial's circular bucket queue, which needs
+ *           one bucket per possible edge length
+ *   bench - runs every engine on the graph, checks that they agree and
+ *           prints the time spent in each main loop
+ *   parse [THREADS]
+ *         - only reads the graph, with THREADS threads (default: one per
+ *           core), and prints the parse throughput
+ *   multi [THREADS]
+ *         - SOURCE_NODE is the name of a file with source nodes. The graph
+ *           is read once and the sources are processed by THREADS threads
+ *           (default: one per core) running the CSR engine. Each source
+ *           produces one line "source => d1 d2 ..." with the distances
+ *           to the nodes of the file in increasing node order, written as
+ *           soon as the source is done, so lines are not in source order.
+ *   p2p TARGET
+ *         - computes only the distance from SOURCE_NODE to TARGET and stops
+ *           as soon as TARGET is extracted from the heap
+ *   bidir TARGET
+ *         - same as p2p, but searches forward from SOURCE_NODE and
+ *           backward from TARGET at the same time
+ *   queries [p2p|bidir|ch]
+ *         - SOURCE_NODE is the name of a file with one "source target"
+ *           query per line. The graph is read once and each query prints
+ *           "source target => distance". The average query time is
+ *           written to std error.
+ *   delta [DELTA [THREADS]]
+ *         - delta-stepping: the nodes are kept in buckets of width DELTA
+ *           and the nodes of the current bucket are relaxed in parallel
+ *           by THREADS threads (default: one per core). DELTA 0 or no DELTA
+ *           picks the maximum edge length divided by the average degree.
+ *   deltabench [DELTA [MAX_THREADS]]
+ *         - runs delta-stepping with 1, 2, 4, ... MAX_THREADS threads,
+ *           checks the distances against the CSR engine and prints the
+ *           time of each run
+ *   chbuild
+ *         - SOURCE_NODE is the name of a file to write a contraction
+ *           hierarchy of the graph to
+ *   ch TARGET
+ *         - FILENAME is a contraction hierarchy written by chbuild; the
+ *           distance from SOURCE_NODE to TARGET is computed with an upward
+ *           search from both ends. queries ch uses the same search.
+ *
+ * All modes but heap read the file into a CSR graph with a parser that
+ * maps the file into memory and splits it at line boundaries between
+ * one thread per core.
+ * FILENAME may also be a binary graph snapshot written by
+ * snapshot/MakeSnapshot, which every mode loads without parsing; edges
+ * of unweighted snapshots get length 1.
  */
 
 #include <iostream>
@@ -30,8 +86,21 @@
 #include <vector>
 #include <utility> // std::pair
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <algorithm>
+#include <limits>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../snapshot/GraphSnapshot.h"
 using namespace std;
 
 typedef set<pair <int, int> >::iterator SetIterator;  // aliasing the set iterator type used
@@ -41,6 +110,150 @@ typedef map<int, list<int> >::iterator MapListIterator;  // aliasing the map lis
 typedef map<int, int>::iterator MapIntIterator;  // aliasing the map int iterator type used
 typedef list<int>::iterator ListIterator;  // aliasing the set iterator type used
 
+/*
+ * Type: CsrGraph
+ * --------------
+ * Compressed sparse row representation of the graph. The edges leaving
+ * node v are stored at indexes offsets[v] to offsets[v + 1] - 1 of the
+ * targets and lengths vectors. Node numbers index the vectors directly,
+ * present[v] is true if node v has a row in the input file.
+ */
+struct CsrGraph {
+  vector<int> offsets;
+  vector<int> targets;
+  vector<int> lengths;
+  vector<char> present;
+};
+
+/*
+ * Type: IndexedHeap
+ * -----------------
+ * Binary min-heap of (node, distance) pairs. position[node] is the index
+ * of node in the nodes vector, or -1 if the node is not on the heap.
+ */
+struct IndexedHeap {
+  vector<pair<int, int> > nodes;
+  vector<int> position;
+};
+
+/*
+ * Type: ParseChunk
+ * ----------------
+ * A part of the input file that one thread parses, from begin up to but
+ * not including end, always starting at the beginning of a line. rows
+ * holds the (node, edge count) pairs of the rows in the chunk and
+ * row_starts the index of the first CSR slot for each row.
+ */
+struct ParseChunk {
+  const char * begin;
+  const char * end;
+  vector<pair<int, int> > rows;
+  vector<int> row_starts;
+  int max_node;
+  int skipped; // node numbers above maxNodes and malformed numbers
+};
+
+/*
+ * Type: Workspace
+ * ---------------
+ * The per-run state of the CSR engine. A workspace can be reused for
+ * many sources on the same graph without allocating new buffers.
+ */
+struct Workspace {
+  vector<int> distances;
+  vector<char> processed;
+  IndexedHeap heap;
+  vector<int> touched; // nodes reached by the last point-to-point query
+  string output; // formatted result line for the multi mode
+};
+
+/*
+ * Type: HierarchyBuilder
+ * ----------------------
+ * The graph while a contraction hierarchy is built, with the original
+ * edges and the shortcuts. When a node is contracted it is removed from
+ * the lists of its neighbors, while its own lists are kept: they then
+ * hold exactly its edges to and from nodes contracted later.
+ * edge_slot[w] is the index of the edge marked -> w in out[marked], or
+ * -1, so addShortcut finds an existing edge without scanning the list.
+ * hops[v] is the number of edges on the path of the witness search to v.
+ */
+struct HierarchyBuilder {
+  vector<vector<pair<int, int> > > out; // (target, length) of outgoing edges
+  vector<vector<pair<int, int> > > in;  // (source, length) of incoming edges
+  vector<int> deleted_neighbors; // number of contracted neighbors of each node
+  vector<int> edge_slot;
+  int marked; // the node whose out edges edge_slot holds, or -1
+  vector<int> hops;
+  Workspace witness;
+};
+
+/*
+ * Type: Barrier
+ * -------------
+ * Blocks the threads that call barrierWait until count of them have
+ * arrived. It can be used again right away for the next round.
+ */
+struct Barrier {
+  mutex lock;
+  condition_variable arrived;
+  int count;
+  int waiting;
+  int generation;
+};
+
+/*
+ * Type: DeltaStepping
+ * -------------------
+ * The state shared by the delta-stepping threads. Node v waits in bucket
+ * distances[v] / delta; the buckets are used circularly, as all waiting
+ * nodes lie within one maximum edge length of the current bucket.
+ * Each thread collects the nodes it improved in its own updates vector,
+ * and thread 0 moves them into buckets between the parallel phases.
+ */
+struct DeltaStepping {
+  CsrGraph * graph;
+  int delta;
+  int threads;
+  vector<atomic<int> > * distances;
+  vector<vector<int> > buckets;
+  int current; // number of the bucket being processed
+  vector<int> frontier; // nodes of the current bucket to relax next
+  vector<int> settled; // nodes of the current bucket already relaxed
+  vector<char> queued; // true for the nodes in frontier
+  vector<vector<int> > updates;
+  bool done;
+  Barrier barrier;
+};
+
+/*
+ * Type: RadixHeap
+ * ---------------
+ * Monotone radix heap of (distance, node) pairs. An entry with key k is
+ * kept in bucket 0 if k equals last, the most recently extracted key,
+ * and otherwise in the bucket given by the highest bit in which k and
+ * last differ. Keys must never be smaller than last, which holds for
+ * Dijkstra with non-negative edge lengths.
+ */
+struct RadixHeap {
+  vector<pair<unsigned, int> > buckets[33];
+  unsigned last;
+  int size;
+};
+
+/*
+ * Type: BucketQueue
+ * -----------------
+ * Dial's bucket queue. Bucket d % buckets.size() holds the nodes with
+ * tentative distance d; with buckets.size() larger than the maximum edge
+ * length all queued distances fall into distinct buckets.
+ */
+struct BucketQueue {
+  vector<vector<int> > buckets;
+  int current;
+  int size;
+};
+
 /* Function prototypes */
 
 string promptUserForFile(ifstream & infile, string prompt);
@@ -62,8 +275,72 @@ void heapDelete(pair<map<int, int>, vector<pair<int, int> > > & heap, int node);
 void heapBubbleDown(pair<map<int, int>, vector<pair<int, int> > > & heap, int nodeIndex);
 void heapDeleteMin(pair<map<int, int>, vector<pair<int, int> > > & heap);
 
+bool readFile(CsrGraph & graph, string filename, int threads);
+bool readSnapshot(CsrGraph & graph, string filename);
+bool readSnapshot(map<int, set<pair<int, int> > > & graph, string filename);
+void parseChunk(ParseChunk & chunk, CsrGraph * graph);
+const char * parseInteger(const char * p, const char * end, int & value);
+void print(CsrGraph & graph, vector<int> & distances);
+void mainloop(CsrGraph & graph, vector<int> & distances);
+void mainloop(CsrGraph & graph, int source, Workspace & workspace);
+void heapInsert(IndexedHeap & heap, int node, int distance);
+void heapDecreaseKey(IndexedHeap & heap, int node, int distance);
+void heapChangeKey(IndexedHeap & heap, int node, int distance);
+pair<int, int> heapDeleteMin(IndexedHeap & heap);
+void heapBubbleUp(IndexedHeap & heap, int nodeIndex);
+void heapBubbleDown(IndexedHeap & heap, int nodeIndex);
+
+void mainloopRadix(CsrGraph & graph, vector<int> & distances);
+void radixHeapInsert(RadixHeap & heap, int node, int distance);
+pair<int, int> radixHeapDeleteMin(RadixHeap & heap);
+void mainloopDial(CsrGraph & graph, vector<int> & distances);
+void bucketQueueInsert(BucketQueue & queue, int node, int distance);
+pair<int, int> bucketQueueDeleteMin(BucketQueue & queue);
+int maxEdgeLength(CsrGraph & graph);
+void benchmark(CsrGraph & graph);
+bool readSources(vector<int> & sources, string filename);
+void multiSource(CsrGraph & graph, vector<int> & sources, int threads);
+void multiSourceWorker(CsrGraph & graph, vector<int> & sources, atomic<int> & next, mutex & output_lock);
+void reverseGraph(CsrGraph & graph, CsrGraph & rgraph);
+void resetWorkspace(Workspace & workspace, int graph_size);
+int pointToPoint(CsrGraph & graph, int source, int target, Workspace & workspace);
+int bidirectional(CsrGraph & graph, CsrGraph & rgraph, int source, int target, Workspace & forward, Workspace & backward);
+void bidirectionalStep(CsrGraph & graph, Workspace & workspace, Workspace & other, long long & best);
+bool readQueries(vector<pair<int, int> > & queries, string filename);
+void print(int source, int target, int distance);
+void runQueries(CsrGraph & graph, CsrGraph & rgraph, vector<pair<int, int> > & queries, string engine, bool report);
+void buildHierarchy(CsrGraph & graph, CsrGraph & up, CsrGraph & down);
+int contractNode(HierarchyBuilder & builder, int node, bool simulate);
+int nodePriority(HierarchyBuilder & builder, int node);
+void witnessSearch(HierarchyBuilder & builder, int source, int skip, int max_distance, int limit, int max_hops);
+void addShortcut(HierarchyBuilder & builder, int source, int target, int length);
+void markEdges(HierarchyBuilder & builder, int source);
+void removeEdge(vector<pair<int, int> > & edges, int node);
+void mainloopDelta(CsrGraph & graph, vector<int> & distances, int delta, int threads);
+void deltaSteppingWorker(DeltaStepping & state, int id);
+void deltaRelax(DeltaStepping & state, int id, vector<int> & nodes, bool light);
+bool deltaNextBucket(DeltaStepping & state);
+void deltaNextFrontier(DeltaStepping & state);
+void deltaDistribute(DeltaStepping & state);
+void barrierWait(Barrier & barrier);
+int defaultDelta(CsrGraph & graph);
+void deltaBenchmark(CsrGraph & graph, int delta, int max_threads);
+int hierarchyQuery(CsrGraph & up, CsrGraph & down, int source, int target, Workspace & forward, Workspace & backward);
+bool writeHierarchy(CsrGraph & up, CsrGraph & down, string filename);
+bool readHierarchy(CsrGraph & up, CsrGraph & down, string filename);
+void writeVector(ofstream & outfile, vector<int> & vec);
+bool readVector(ifstream & infile, vector<int> & vec);
+bool validHierarchyGraph(CsrGraph & graph, int graph_size);
+
 int sourceNode, maxNodes;
 const int MAX_DIST = 1000000;
+const int INF_DIST = numeric_limits<int>::max(); // distance of nodes not reached yet
+const int MAX_BUCKETS = 1 << 24; // largest bucket array dial mode will allocate
+const int WITNESS_LIMIT = 500; // nodes a witness search may settle before giving up
+const int SIMULATE_LIMIT = 50; // the same limit when only estimating a node priority
+const int WITNESS_HOPS = 5; // edges a witness path may have
+const int SIMULATE_HOPS = 2; // the same limit when only estimating a node priority
+const char HIERARCHY_MAGIC[8] = {'D', 'J', 'K', 'C', 'H', '0', '0', '1'};
 
 /* Main program */
 
@@ -75,14 +352,51 @@ int main(int argc, char* argv[]) {
 
   if (argc < 3) {
     cerr << "Invalid number of arguments\n"
-	 <<"Usage: " << argv[0] << " SOURCE_NODE MAX_NODES [FILENAME]" << endl;
+	 <<"Usage: " << argv[0] << " SOURCE_NODE MAX_NODES [FILENAME [MODE]]" << endl;
     return 1;
-  } else {
+  }
+  string mode = "heap";
+  if (argc > 4) {
+    mode = argv[4];
+  }
+  if (mode != "heap" && mode != "csr" && mode != "radix" && mode != "dial" && mode != "bench" &&
+      mode != "multi" && mode != "p2p" && mode != "bidir" && mode != "queries" &&
+      mode != "chbuild" && mode != "ch" && mode != "delta" && mode != "deltabench" && mode != "parse") {
+    cerr << "Unknown mode: " << mode << "\n"
+	 << "Usage: " << argv[0] << " SOURCE_NODE MAX_NODES [FILENAME [heap|csr|radix|dial|bench]]\n"
+	 << "       " << argv[0] << " SOURCE_NODE MAX_NODES FILENAME delta|deltabench [DELTA [THREADS]]\n"
+	 << "       " << argv[0] << " SOURCE_NODE MAX_NODES FILENAME p2p|bidir TARGET\n"
+	 << "       " << argv[0] << " SOURCE_NODE MAX_NODES FILENAME parse [THREADS]\n"
+	 << "       " << argv[0] << " SOURCES_FILE MAX_NODES FILENAME multi [THREADS]\n"
+	 << "       " << argv[0] << " QUERY_FILE MAX_NODES FILENAME queries [p2p|bidir|ch]\n"
+	 << "       " << argv[0] << " CH_FILE MAX_NODES FILENAME chbuild\n"
+	 << "       " << argv[0] << " SOURCE_NODE MAX_NODES CH_FILE ch TARGET" << endl;
+    return 1;
+  }
+  if ((mode == "p2p" || mode == "bidir" || mode == "ch") && argc < 6) {
+    cerr << "Missing target node\n"
+	 << "Usage: " << argv[0] << " SOURCE_NODE MAX_NODES FILENAME " << mode << " TARGET" << endl;
+    return 1;
+  }
+  vector<int> sources;
+  vector<pair<int, int> > queries;
+  if (mode == "multi") {
+    if (!readSources(sources, argv[1])) {
+      cerr << "No such file: " << argv[1] << endl;
+      return 1;
+    }
+  } else if (mode == "queries") {
+    if (!readQueries(queries, argv[1])) {
+      cerr << "No such file: " << argv[1] << endl;
+      return 1;
+    }
+  } else if (mode != "chbuild") {
     sourceNode = stringToInteger(argv[1]);
-    maxNodes = stringToInteger(argv[2]);
   }
+  maxNodes = stringToInteger(argv[2]);
+  string filename;
   if (argc < 4) {
-    promptUserForFile(infile, "Input file: ");
+    filename = promptUserForFile(infile, "Input file: ");
   }
   else {
     if (!testFileName(infile, argv[3])) {
@@ -90,9 +404,102 @@ int main(int argc, char* argv[]) {
 	   <<"Usage: " << argv[0] << " FILENAME" << endl;
       return 1;
     }
+    filename = argv[3];
   }
   // cout << "start: " << sourceNode << " max nodes: " << maxNodes << endl;
 
+  if (mode == "p2p" || mode == "bidir" || mode == "ch") {
+    queries.push_back(make_pair(sourceNode, stringToInteger(argv[5])));
+  }
+  string engine = mode;
+  if (mode == "queries") {
+    engine = argc > 5 ? argv[5] : "p2p";
+  }
+  if (engine == "ch") {
+    infile.close();
+    CsrGraph up, down;
+    if (!readHierarchy(up, down, filename)) {
+      cerr << "Not a contraction hierarchy file: " << filename << endl;
+      return 1;
+    }
+    runQueries(up, down, queries, engine, mode == "queries");
+    return 0;
+  }
+
+  if (mode != "heap") {
+    infile.close();
+    CsrGraph csr_graph;
+    int parse_threads = thread::hardware_concurrency();
+    if (mode == "parse" && argc > 5) parse_threads = stringToInteger(argv[5]);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (!readFile(csr_graph, filename, max(parse_threads, 1))) {
+      cerr << "Unable to read " << filename << endl;
+      return 1;
+    }
+    double parse_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (mode == "parse" || mode == "bench") {
+      struct stat file_stat;
+      stat(filename.c_str(), &file_stat);
+      double megabytes = file_stat.st_size / 1e6;
+      cout << "parsed " << megabytes << " MB in " << parse_time << " s: "
+	   << megabytes / parse_time << " MB/s" << endl;
+      if (mode == "parse") return 0;
+    }
+    if (mode == "bench") {
+      benchmark(csr_graph);
+      return 0;
+    }
+    if (mode == "multi") {
+      int threads = argc > 5 ? stringToInteger(argv[5]) : thread::hardware_concurrency();
+      multiSource(csr_graph, sources, max(threads, 1));
+      return 0;
+    }
+    if (mode == "p2p" || mode == "bidir" || mode == "queries") {
+      CsrGraph csr_rgraph;
+      if (engine == "bidir") reverseGraph(csr_graph, csr_rgraph);
+      runQueries(csr_graph, csr_rgraph, queries, engine, mode == "queries");
+      return 0;
+    }
+    if (mode == "chbuild") {
+      CsrGraph up, down;
+      buildHierarchy(csr_graph, up, down);
+      if (!writeHierarchy(up, down, argv[1])) {
+	cerr << "Unable to write " << argv[1] << endl;
+	return 1;
+      }
+      cout << "nodes: " << up.present.size() << " edges: " << csr_graph.targets.size()
+	   << " hierarchy edges: " << up.targets.size() + down.targets.size() << endl;
+      return 0;
+    }
+    if (mode == "delta" || mode == "deltabench") {
+      int delta = argc > 5 ? stringToInteger(argv[5]) : 0;
+      if (delta == 0) delta = defaultDelta(csr_graph);
+      int threads = argc > 6 ? stringToInteger(argv[6]) : thread::hardware_concurrency();
+      if (delta < 1 || maxEdgeLength(csr_graph) / delta >= MAX_BUCKETS) {
+	cerr << "Invalid delta: " << delta << endl;
+	return 1;
+      }
+      if (mode == "deltabench") {
+	deltaBenchmark(csr_graph, delta, max(threads, 1));
+      } else {
+	vector<int> csr_distances;
+	mainloopDelta(csr_graph, csr_distances, delta, max(threads, 1));
+	print(csr_graph, csr_distances);
+      }
+      return 0;
+    }
+    if (mode == "dial" && maxEdgeLength(csr_graph) >= MAX_BUCKETS) {
+      cerr << "Edge lengths too large for dial mode, use radix mode" << endl;
+      return 1;
+    }
+    vector<int> csr_distances;
+    if (mode == "csr") mainloop(csr_graph, csr_distances);
+    else if (mode == "radix") mainloopRadix(csr_graph, csr_distances);
+    else mainloopDial(csr_graph, csr_distances);
+    print(csr_graph, csr_distances);
+    return 0;
+  }
+
   /*
    * graph is a map with vertices as keys pointing to a
    * set of pair<int, int> which represent target nodes.
@@ -100,7 +507,15 @@ int main(int argc, char* argv[]) {
    * the second of the pair is the edge length.
    */
   map<int, set<pair<int, int> > > graph;
-  readFile(graph, infile);
+  if (isSnapshot(filename)) {
+    infile.close();
+    if (!readSnapshot(graph, filename)) {
+      cerr << "Unable to read " << filename << endl;
+      return 1;
+    }
+  } else {
+    readFile(graph, infile);
+  }
   // print(graph);
 
   set<int> processed; // set with th vertices processed so far
@@ -261,6 +676,1188 @@ void heapBubbleDown(pair<map<int, int>, vector<pair<int, int> > > & heap, int no
 }
 
 
+/*
+ * Function: mainloop
+ * Usage: vector<int> distances; mainloop(graph, distances);
+ * ---------------------------------------------------------
+ * CSR variant of the main loop. Only the source node is put on the heap
+ * initially; a target node is inserted the first time it is reached and
+ * its key is decreased in place when a shorter path is found. The edges
+ * of the extracted node are scanned directly in the CSR arrays.
+ * On return distances[v] is the shortest path distance to v, or INF_DIST
+ * if v is not reachable from the source node.
+ */
+void mainloop(CsrGraph & graph, vector<int> & distances) {
+  Workspace workspace;
+  mainloop(graph, sourceNode, workspace);
+  distances.swap(workspace.distances);
+}
+
+/*
+ * Function: mainloop
+ * Usage: Workspace workspace; mainloop(graph, source, workspace);
+ * ---------------------------------------------------------------
+ * Runs the CSR engine from source, leaving the distances in the
+ * workspace. The buffers of the workspace keep their capacity between
+ * calls, and the heap is always empty when a run ends, so only the
+ * distances and the processed flags have to be reset.
+ */
+void mainloop(CsrGraph & graph, int source, Workspace & workspace) {
+  int graph_size = graph.present.size();
+  vector<int> & distances = workspace.distances;
+  vector<char> & processed = workspace.processed;
+  IndexedHeap & heap = workspace.heap;
+  distances.assign(graph_size, INF_DIST);
+  processed.assign(graph_size, 0);
+  if ((int) heap.position.size() != graph_size) heap.position.assign(graph_size, -1);
+  if (source < 0 || source >= graph_size) return;
+
+  distances[source] = 0;
+  heapInsert(heap, source, 0);
+
+  while (!heap.nodes.empty()) {
+    pair<int, int> min_node = heapDeleteMin(heap); // extract min
+    int node = min_node.first;
+    int node_value = min_node.second;
+    processed[node] = 1;
+
+    int edge_end = graph.offsets[node + 1];
+    for (int e = graph.offsets[node]; e < edge_end; e++) {
+      int edge_node = graph.targets[e];
+      if (processed[edge_node]) continue;
+      int greedy_score = node_value + graph.lengths[e];
+      if (greedy_score < distances[edge_node]) { // if new score is better than old score
+	if (distances[edge_node] == INF_DIST) {
+	  heapInsert(heap, edge_node, greedy_score);
+	} else {
+	  heapDecreaseKey(heap, edge_node, greedy_score);
+	}
+	distances[edge_node] = greedy_score;
+      }
+    }
+  }
+}
+
+void heapInsert(IndexedHeap & heap, int node, int distance) {
+  heap.position[node] = heap.nodes.size();
+  heap.nodes.push_back(make_pair(node, distance));
+  heapBubbleUp(heap, heap.nodes.size() - 1);
+}
+
+void heapDecreaseKey(IndexedHeap & heap, int node, int distance) {
+  int node_index = heap.position[node];
+  heap.nodes[node_index].second = distance;
+  heapBubbleUp(heap, node_index);
+}
+
+void heapChangeKey(IndexedHeap & heap, int node, int distance) {
+  int node_index = heap.position[node];
+  int old_distance = heap.nodes[node_index].second;
+  heap.nodes[node_index].second = distance;
+  if (distance < old_distance) heapBubbleUp(heap, node_index);
+  else heapBubbleDown(heap, node_index);
+}
+
+pair<int, int> heapDeleteMin(IndexedHeap & heap) {
+  pair<int, int> min_node = heap.nodes[0];
+  heap.position[min_node.first] = -1;
+  pair<int, int> last_node = heap.nodes.back();
+  heap.nodes.pop_back();
+  if (!heap.nodes.empty()) {
+    heap.nodes[0] = last_node;
+    heap.position[last_node.first] = 0;
+    heapBubbleDown(heap, 0);
+  }
+  return min_node;
+}
+
+/*
+ * Function: heapBubbleUp
+ * ----------------------
+ * Moves the node at nodeIndex up towards the root until its parent is
+ * not larger. The node is held aside and the parents are shifted down,
+ * so each level costs one move instead of a full swap.
+ */
+void heapBubbleUp(IndexedHeap & heap, int nodeIndex) {
+  pair<int, int> node = heap.nodes[nodeIndex];
+  while (nodeIndex > 0) {
+    int parent_node_index = (nodeIndex - 1) / 2;
+    if (heap.nodes[parent_node_index].second <= node.second) break;
+    heap.nodes[nodeIndex] = heap.nodes[parent_node_index];
+    heap.position[heap.nodes[nodeIndex].first] = nodeIndex;
+    nodeIndex = parent_node_index;
+  }
+  heap.nodes[nodeIndex] = node;
+  heap.position[node.first] = nodeIndex;
+}
+
+void heapBubbleDown(IndexedHeap & heap, int nodeIndex) {
+  pair<int, int> node = heap.nodes[nodeIndex];
+  int vec_size = heap.nodes.size();
+  while (true) {
+    int child_node_index = nodeIndex * 2 + 1; // left child
+    if (child_node_index >= vec_size) break;
+    if (child_node_index + 1 < vec_size &&
+	heap.nodes[child_node_index + 1].second < heap.nodes[child_node_index].second) {
+      child_node_index++; // right child is smaller
+    }
+    if (node.second <= heap.nodes[child_node_index].second) break;
+    heap.nodes[nodeIndex] = heap.nodes[child_node_index];
+    heap.position[heap.nodes[nodeIndex].first] = nodeIndex;
+    nodeIndex = child_node_index;
+  }
+  heap.nodes[nodeIndex] = node;
+  heap.position[node.first] = nodeIndex;
+}
+
+
+/*
+ * Function: mainloopRadix
+ * Usage: vector<int> distances; mainloopRadix(graph, distances);
+ * --------------------------------------------------------------
+ * Same as the CSR main loop, but with a radix heap as priority queue.
+ * The radix heap has no decrease-key, so an improved node is inserted
+ * again and outdated entries are skipped when they are extracted.
+ */
+void mainloopRadix(CsrGraph & graph, vector<int> & distances) {
+  int graph_size = graph.present.size();
+  distances.assign(graph_size, INF_DIST);
+  if (sourceNode < 0 || sourceNode >= graph_size) return;
+
+  vector<char> processed(graph_size, 0);
+  RadixHeap heap;
+  heap.last = 0;
+  heap.size = 0;
+  distances[sourceNode] = 0;
+  radixHeapInsert(heap, sourceNode, 0);
+
+  while (heap.size > 0) {
+    pair<int, int> min_node = radixHeapDeleteMin(heap);
+    int node = min_node.first;
+    if (processed[node]) continue; // outdated entry
+    processed[node] = 1;
+
+    int node_value = min_node.second;
+    int edge_end = graph.offsets[node + 1];
+    for (int e = graph.offsets[node]; e < edge_end; e++) {
+      int edge_node = graph.targets[e];
+      int greedy_score = node_value + graph.lengths[e];
+      if (greedy_score < distances[edge_node]) {
+	distances[edge_node] = greedy_score;
+	radixHeapInsert(heap, edge_node, greedy_score);
+      }
+    }
+  }
+}
+
+void radixHeapInsert(RadixHeap & heap, int node, int distance) {
+  unsigned key = distance;
+  int bucket = key == heap.last ? 0 : 32 - __builtin_clz(key ^ heap.last);
+  heap.buckets[bucket].push_back(make_pair(key, node));
+  heap.size++;
+}
+
+/*
+ * Function: radixHeapDeleteMin
+ * ----------------------------
+ * Removes and returns a (node, distance) pair with minimum distance.
+ * If bucket 0 is empty, the first non-empty bucket is emptied: its
+ * minimum becomes the new last key and all its entries are moved to
+ * lower buckets, so every entry is moved at most 32 times in total.
+ */
+pair<int, int> radixHeapDeleteMin(RadixHeap & heap) {
+  if (heap.buckets[0].empty()) {
+    int i = 1;
+    while (heap.buckets[i].empty()) i++;
+    vector<pair<unsigned, int> > & bucket = heap.buckets[i];
+    unsigned min_key = bucket[0].first;
+    for (size_t j = 1; j < bucket.size(); j++) min_key = min(min_key, bucket[j].first);
+    heap.last = min_key;
+    for (size_t j = 0; j < bucket.size(); j++) {
+      unsigned key = bucket[j].first;
+      int target = key == heap.last ? 0 : 32 - __builtin_clz(key ^ heap.last);
+      heap.buckets[target].push_back(bucket[j]);
+    }
+    bucket.clear();
+  }
+  pair<unsigned, int> entry = heap.buckets[0].back();
+  heap.buckets[0].pop_back();
+  heap.size--;
+  return make_pair(entry.second, (int) entry.first);
+}
+
+/*
+ * Function: mainloopDial
+ * Usage: vector<int> distances; mainloopDial(graph, distances);
+ * -------------------------------------------------------------
+ * Same as the CSR main loop, but with Dial's bucket queue as priority
+ * queue. Like the radix heap, improved nodes are inserted again and
+ * outdated entries are skipped.
+ */
+void mainloopDial(CsrGraph & graph, vector<int> & distances) {
+  int graph_size = graph.present.size();
+  distances.assign(graph_size, INF_DIST);
+  if (sourceNode < 0 || sourceNode >= graph_size) return;
+
+  vector<char> processed(graph_size, 0);
+  BucketQueue queue;
+  queue.buckets.resize(maxEdgeLength(graph) + 1);
+  queue.current = 0;
+  queue.size = 0;
+  distances[sourceNode] = 0;
+  bucketQueueInsert(queue, sourceNode, 0);
+
+  while (queue.size > 0) {
+    pair<int, int> min_node = bucketQueueDeleteMin(queue);
+    int node = min_node.first;
+    if (processed[node] || min_node.second != distances[node]) continue; // outdated entry
+    processed[node] = 1;
+
+    int node_value = min_node.second;
+    int edge_end = graph.offsets[node + 1];
+    for (int e = graph.offsets[node]; e < edge_end; e++) {
+      int edge_node = graph.targets[e];
+      int greedy_score = node_value + graph.lengths[e];
+      if (greedy_score < distances[edge_node]) {
+	distances[edge_node] = greedy_score;
+	bucketQueueInsert(queue, edge_node, greedy_score);
+      }
+    }
+  }
+}
+
+void bucketQueueInsert(BucketQueue & queue, int node, int distance) {
+  queue.buckets[distance % queue.buckets.size()].push_back(node);
+  queue.size++;
+}
+
+/*
+ * Function: bucketQueueDeleteMin
+ * ------------------------------
+ * Removes and returns a (node, distance) pair with minimum distance by
+ * advancing the current distance until a non-empty bucket is found.
+ */
+pair<int, int> bucketQueueDeleteMin(BucketQueue & queue) {
+  int bucket_count = queue.buckets.size();
+  while (queue.buckets[queue.current % bucket_count].empty()) queue.current++;
+  vector<int> & bucket = queue.buckets[queue.current % bucket_count];
+  int node = bucket.back();
+  bucket.pop_back();
+  queue.size--;
+  return make_pair(node, queue.current);
+}
+
+int maxEdgeLength(CsrGraph & graph) {
+  int max_length = 0;
+  for (size_t e = 0; e < graph.lengths.size(); e++) max_length = max(max_length, graph.lengths[e]);
+  return max_length;
+}
+
+/*
+ * Function: benchmark
+ * Usage: benchmark(graph);
+ * ------------------------
+ * Runs every engine from sourceNode on the graph and prints the time
+ * spent in each main loop, not counting the time to read the file.
+ * The map based engine gets a copy of the graph in its own format.
+ * The distances of each engine are compared with the CSR engine.
+ */
+void benchmark(CsrGraph & graph) {
+  typedef chrono::steady_clock Clock;
+  int graph_size = graph.present.size();
+  cout << "nodes: " << graph_size << " edges: " << graph.targets.size() << endl;
+
+  vector<int> expected;
+  Clock::time_point start = Clock::now();
+  mainloop(graph, expected);
+  double csr_time = chrono::duration<double>(Clock::now() - start).count();
+
+  map<int, set<pair<int, int> > > map_graph;
+  for (int v = 0; v < graph_size; v++) {
+    if (!graph.present[v]) continue;
+    set<pair<int, int> > & row = map_graph[v];
+    for (int e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+      row.insert(make_pair(graph.targets[e], graph.lengths[e]));
+    }
+  }
+  map<int, int> distances;
+  for (MapIterator it = map_graph.begin(); it != map_graph.end(); ++it) {
+    distances[it -> first] = MAX_DIST;
+  }
+  distances[sourceNode] = 0;
+  set<int> processed;
+  map<int, list<int> > pathmap;
+  start = Clock::now();
+  mainloop(map_graph, processed, distances, pathmap);
+  double heap_time = chrono::duration<double>(Clock::now() - start).count();
+  bool heap_ok = true;
+  for (MapIntIterator it = distances.begin(); it != distances.end(); ++it) {
+    int value = expected[it -> first] == INF_DIST ? MAX_DIST : expected[it -> first];
+    if (it -> second != value) heap_ok = false;
+  }
+
+  vector<int> radix_distances;
+  start = Clock::now();
+  mainloopRadix(graph, radix_distances);
+  double radix_time = chrono::duration<double>(Clock::now() - start).count();
+
+  cout << "heap:  " << heap_time << " s" << (heap_ok ? "" : " MISMATCH") << endl;
+  cout << "csr:   " << csr_time << " s" << endl;
+  cout << "radix: " << radix_time << " s" << (radix_distances == expected ? "" : " MISMATCH") << endl;
+  if (maxEdgeLength(graph) < MAX_BUCKETS) {
+    vector<int> dial_distances;
+    start = Clock::now();
+    mainloopDial(graph, dial_distances);
+    double dial_time = chrono::duration<double>(Clock::now() - start).count();
+    cout << "dial:  " << dial_time << " s" << (dial_distances == expected ? "" : " MISMATCH") << endl;
+  }
+}
+
+
+/*
+ * Function: mainloopDelta
+ * Usage: vector<int> distances; mainloopDelta(graph, distances, delta, threads);
+ * -----------------------------------------------------------------------------
+ * Delta-stepping shortest paths from sourceNode. Edges of length at most
+ * delta are light, the others heavy. The smallest non-empty bucket is
+ * processed in phases: all threads relax the light edges of the frontier
+ * nodes in parallel, and nodes that get a new distance in the same bucket
+ * form the next frontier. When the bucket stays empty the heavy edges of
+ * all its nodes are relaxed once, since they can only reach later
+ * buckets. Distances are lowered with compare-and-swap, so the result
+ * does not depend on the number of threads.
+ */
+void mainloopDelta(CsrGraph & graph, vector<int> & distances, int delta, int threads) {
+  int graph_size = graph.present.size();
+  distances.assign(graph_size, INF_DIST);
+  if (sourceNode < 0 || sourceNode >= graph_size) return;
+
+  vector<atomic<int> > shared_distances(graph_size);
+  for (int v = 0; v < graph_size; v++) shared_distances[v].store(INF_DIST, memory_order_relaxed);
+  shared_distances[sourceNode].store(0, memory_order_relaxed);
+
+  DeltaStepping state;
+  state.graph = &graph;
+  state.delta = delta;
+  state.threads = threads;
+  state.distances = &shared_distances;
+  state.buckets.resize(maxEdgeLength(graph) / delta + 2);
+  state.buckets[0].push_back(sourceNode);
+  state.current = 0;
+  state.queued.assign(graph_size, 0);
+  state.updates.resize(threads);
+  state.done = false;
+  state.barrier.count = threads;
+  state.barrier.waiting = 0;
+  state.barrier.generation = 0;
+
+  vector<thread> workers;
+  for (int i = 1; i < threads; i++) {
+    workers.push_back(thread(deltaSteppingWorker, ref(state), i));
+  }
+  deltaSteppingWorker(state, 0);
+  for (size_t i = 0; i < workers.size(); i++) {
+    workers[i].join();
+  }
+  for (int v = 0; v < graph_size; v++) distances[v] = shared_distances[v].load(memory_order_relaxed);
+}
+
+/*
+ * Function: deltaSteppingWorker
+ * -----------------------------
+ * The loop run by every delta-stepping thread. The parallel relaxation
+ * phases are separated by barriers; in between, thread 0 alone moves the
+ * updated nodes into the frontier and the buckets.
+ */
+void deltaSteppingWorker(DeltaStepping & state, int id) {
+  while (true) {
+    if (id == 0) state.done = !deltaNextBucket(state);
+    barrierWait(state.barrier);
+    if (state.done) return;
+    while (!state.frontier.empty()) { // light phases
+      deltaRelax(state, id, state.frontier, true);
+      barrierWait(state.barrier);
+      if (id == 0) deltaNextFrontier(state);
+      barrierWait(state.barrier);
+    }
+    deltaRelax(state, id, state.settled, false); // heavy phase
+    barrierWait(state.barrier);
+    if (id == 0) deltaDistribute(state);
+  }
+}
+
+/*
+ * Function: deltaRelax
+ * --------------------
+ * Relaxes the light or the heavy edges of every threads-th node of nodes,
+ * starting at index id, and records the improved nodes in updates[id].
+ */
+void deltaRelax(DeltaStepping & state, int id, vector<int> & nodes, bool light) {
+  CsrGraph & graph = *state.graph;
+  vector<atomic<int> > & distances = *state.distances;
+  vector<int> & updates = state.updates[id];
+  int node_count = nodes.size();
+  for (int i = id; i < node_count; i += state.threads) {
+    int node = nodes[i];
+    int node_value = distances[node].load(memory_order_relaxed);
+    int edge_end = graph.offsets[node + 1];
+    for (int e = graph.offsets[node]; e < edge_end; e++) {
+      if ((graph.lengths[e] <= state.delta) != light) continue;
+      int edge_node = graph.targets[e];
+      int greedy_score = node_value + graph.lengths[e];
+      int old_value = distances[edge_node].load(memory_order_relaxed);
+      while (greedy_score < old_value) {
+	if (distances[edge_node].compare_exchange_weak(old_value, greedy_score, memory_order_relaxed)) {
+	  updates.push_back(edge_node);
+	  break;
+	}
+      }
+    }
+  }
+}
+
+/*
+ * Function: deltaNextBucket
+ * -------------------------
+ * Advances to the next bucket that holds a node whose distance still
+ * belongs to it and makes those nodes the frontier. Entries of nodes
+ * that moved to an earlier bucket since they were added are dropped.
+ * Returns false when all buckets are empty.
+ */
+bool deltaNextBucket(DeltaStepping & state) {
+  vector<atomic<int> > & distances = *state.distances;
+  int bucket_count = state.buckets.size();
+  for (int scanned = 0; scanned < bucket_count; scanned++, state.current++) {
+    vector<int> & bucket = state.buckets[state.current % bucket_count];
+    for (size_t i = 0; i < bucket.size(); i++) {
+      int node = bucket[i];
+      if (distances[node].load(memory_order_relaxed) / state.delta == state.current && !state.queued[node]) {
+	state.queued[node] = 1;
+	state.frontier.push_back(node);
+      }
+    }
+    bucket.clear();
+    if (!state.frontier.empty()) return true;
+  }
+  return false;
+}
+
+/*
+ * Function: deltaNextFrontier
+ * ---------------------------
+ * Moves the relaxed frontier to the settled nodes and builds the next
+ * frontier from the nodes that were improved into the current bucket.
+ * Nodes improved into later buckets are added to those buckets.
+ */
+void deltaNextFrontier(DeltaStepping & state) {
+  vector<atomic<int> > & distances = *state.distances;
+  int bucket_count = state.buckets.size();
+  for (size_t i = 0; i < state.frontier.size(); i++) {
+    state.queued[state.frontier[i]] = 0;
+    state.settled.push_back(state.frontier[i]);
+  }
+  state.frontier.clear();
+  for (int t = 0; t < state.threads; t++) {
+    vector<int> & updates = state.updates[t];
+    for (size_t i = 0; i < updates.size(); i++) {
+      int node = updates[i];
+      int bucket = distances[node].load(memory_order_relaxed) / state.delta;
+      if (bucket == state.current) {
+	if (!state.queued[node]) {
+	  state.queued[node] = 1;
+	  state.frontier.push_back(node);
+	}
+      } else {
+	state.buckets[bucket % bucket_count].push_back(node);
+      }
+    }
+    updates.clear();
+  }
+}
+
+/*
+ * Function: deltaDistribute
+ * -------------------------
+ * Adds the nodes improved by the heavy phase to their buckets and moves
+ * on from the current bucket.
+ */
+void deltaDistribute(DeltaStepping & state) {
+  vector<atomic<int> > & distances = *state.distances;
+  int bucket_count = state.buckets.size();
+  for (int t = 0; t < state.threads; t++) {
+    vector<int> & updates = state.updates[t];
+    for (size_t i = 0; i < updates.size(); i++) {
+      int bucket = distances[updates[i]].load(memory_order_relaxed) / state.delta;
+      state.buckets[bucket % bucket_count].push_back(updates[i]);
+    }
+    updates.clear();
+  }
+  state.settled.clear();
+  state.current++;
+}
+
+void barrierWait(Barrier & barrier) {
+  unique_lock<mutex> guard(barrier.lock);
+  int generation = barrier.generation;
+  if (++barrier.waiting == barrier.count) {
+    barrier.waiting = 0;
+    barrier.generation++;
+    barrier.arrived.notify_all();
+  } else {
+    while (generation == barrier.generation) barrier.arrived.wait(guard);
+  }
+}
+
+/*
+ * Function: defaultDelta
+ * ----------------------
+ * Returns the maximum edge length divided by the average out-degree,
+ * the usual starting point for tuning delta, but at least 1.
+ */
+int defaultDelta(CsrGraph & graph) {
+  long long edge_count = graph.targets.size();
+  long long graph_size = graph.present.size();
+  if (edge_count == 0) return 1;
+  return max(1LL, maxEdgeLength(graph) * graph_size / edge_count);
+}
+
+/*
+ * Function: deltaBenchmark
+ * Usage: deltaBenchmark(graph, delta, max_threads);
+ * -------------------------------------------------
+ * Runs delta-stepping from sourceNode with 1, 2, 4, ... max_threads
+ * threads and prints the time of each run and of the CSR engine. The
+ * distances of each run are compared with the CSR engine.
+ */
+void deltaBenchmark(CsrGraph & graph, int delta, int max_threads) {
+  typedef chrono::steady_clock Clock;
+  cout << "nodes: " << graph.present.size() << " edges: " << graph.targets.size()
+       << " delta: " << delta << endl;
+  vector<int> expected;
+  Clock::time_point start = Clock::now();
+  mainloop(graph, expected);
+  double csr_time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "csr:        " << csr_time << " s" << endl;
+  for (int threads = 1; ; threads = min(threads * 2, max_threads)) {
+    vector<int> distances;
+    start = Clock::now();
+    mainloopDelta(graph, distances, delta, threads);
+    double delta_time = chrono::duration<double>(Clock::now() - start).count();
+    cout << "threads " << threads << ": " << delta_time << " s"
+	 << (distances == expected ? "" : " MISMATCH") << endl;
+    if (threads == max_threads) break;
+  }
+}
+
+/*
+ * Function: multiSource
+ * Usage: multiSource(graph, sources, threads);
+ * --------------------------------------------
+ * Computes the distances from every node in sources. The worker threads
+ * take the next unprocessed source from a shared counter, so a slow
+ * source does not hold up the others, and each thread keeps one
+ * workspace for all of its sources.
+ */
+void multiSource(CsrGraph & graph, vector<int> & sources, int threads) {
+  atomic<int> next(0);
+  mutex output_lock;
+  vector<thread> workers;
+  for (int i = 0; i < threads; i++) {
+    workers.push_back(thread(multiSourceWorker, ref(graph), ref(sources), ref(next), ref(output_lock)));
+  }
+  for (int i = 0; i < threads; i++) {
+    workers[i].join();
+  }
+  cout.flush();
+}
+
+void multiSourceWorker(CsrGraph & graph, vector<int> & sources, atomic<int> & next, mutex & output_lock) {
+  Workspace workspace;
+  int graph_size = graph.present.size();
+  int source_count = sources.size();
+  char number[16];
+  for (int i = next++; i < source_count; i = next++) {
+    mainloop(graph, sources[i], workspace);
+    string & output = workspace.output;
+    output.clear();
+    snprintf(number, sizeof number, "%d =>", sources[i]);
+    output += number;
+    for (int v = 0; v < graph_size; v++) {
+      if (!graph.present[v]) continue;
+      int distance = workspace.distances[v] == INF_DIST ? MAX_DIST : workspace.distances[v];
+      snprintf(number, sizeof number, " %d", distance);
+      output += number;
+    }
+    output += '\n';
+    lock_guard<mutex> guard(output_lock);
+    cout.write(output.data(), output.size());
+  }
+}
+
+/*
+ * Function: readSources
+ * Usage: vector<int> sources; readSources(sources, filename);
+ * -----------------------------------------------------------
+ * Reads the whitespace separated source nodes from the named file.
+ * Returns false if the file cannot be opened.
+ */
+bool readSources(vector<int> & sources, string filename) {
+  ifstream sourcefile(filename.c_str());
+  if (sourcefile.fail()) return false;
+  int node;
+  while (sourcefile >> node) {
+    sources.push_back(node);
+  }
+  return true;
+}
+
+
+/*
+ * Function: pointToPoint
+ * Usage: int distance = pointToPoint(graph, source, target, workspace);
+ * ---------------------------------------------------------------------
+ * Runs the CSR engine from source until target is extracted from the
+ * heap and returns its distance, or INF_DIST if target is not reachable.
+ * Only the nodes reached by the previous query are reset, so a query
+ * that settles a few nodes does not pay for the size of the graph.
+ */
+int pointToPoint(CsrGraph & graph, int source, int target, Workspace & workspace) {
+  int graph_size = graph.present.size();
+  resetWorkspace(workspace, graph_size);
+  if (source < 0 || source >= graph_size || target < 0 || target >= graph_size) return INF_DIST;
+
+  vector<int> & distances = workspace.distances;
+  vector<char> & processed = workspace.processed;
+  IndexedHeap & heap = workspace.heap;
+  distances[source] = 0;
+  workspace.touched.push_back(source);
+  heapInsert(heap, source, 0);
+
+  while (!heap.nodes.empty()) {
+    pair<int, int> min_node = heapDeleteMin(heap);
+    int node = min_node.first;
+    int node_value = min_node.second;
+    if (node == target) return node_value; // early exit
+    processed[node] = 1;
+
+    int edge_end = graph.offsets[node + 1];
+    for (int e = graph.offsets[node]; e < edge_end; e++) {
+      int edge_node = graph.targets[e];
+      if (processed[edge_node]) continue;
+      int greedy_score = node_value + graph.lengths[e];
+      if (greedy_score < distances[edge_node]) {
+	if (distances[edge_node] == INF_DIST) {
+	  heapInsert(heap, edge_node, greedy_score);
+	  workspace.touched.push_back(edge_node);
+	} else {
+	  heapDecreaseKey(heap, edge_node, greedy_score);
+	}
+	distances[edge_node] = greedy_score;
+      }
+    }
+  }
+  return INF_DIST;
+}
+
+/*
+ * Function: bidirectional
+ * Usage: int distance = bidirectional(graph, rgraph, source, target, forward, backward);
+ * -------------------------------------------------------------------------------------
+ * Bidirectional variant of pointToPoint. The forward search runs on graph
+ * from source and the backward search on the reverse graph rgraph from
+ * target; each step extracts from the heap with the smaller minimum.
+ * Every edge that reaches a node seen by the other search gives a
+ * candidate path length, and the search stops as soon as the two heap
+ * minimums add up to at least the best candidate.
+ */
+int bidirectional(CsrGraph & graph, CsrGraph & rgraph, int source, int target, Workspace & forward, Workspace & backward) {
+  int graph_size = graph.present.size();
+  resetWorkspace(forward, graph_size);
+  resetWorkspace(backward, graph_size);
+  if (source < 0 || source >= graph_size || target < 0 || target >= graph_size) return INF_DIST;
+  if (source == target) return 0;
+
+  forward.distances[source] = 0;
+  forward.touched.push_back(source);
+  heapInsert(forward.heap, source, 0);
+  backward.distances[target] = 0;
+  backward.touched.push_back(target);
+  heapInsert(backward.heap, target, 0);
+
+  long long best = INF_DIST; // shortest path length found so far
+  while (!forward.heap.nodes.empty() && !backward.heap.nodes.empty()) {
+    long long forward_min = forward.heap.nodes[0].second;
+    long long backward_min = backward.heap.nodes[0].second;
+    if (forward_min + backward_min >= best) break;
+    if (forward_min <= backward_min) {
+      bidirectionalStep(graph, forward, backward, best);
+    } else {
+      bidirectionalStep(rgraph, backward, forward, best);
+    }
+  }
+  return best;
+}
+
+/*
+ * Function: bidirectionalStep
+ * ---------------------------
+ * Extracts the minimum node of one search direction, relaxes its edges
+ * and updates best with the paths that meet the other direction.
+ */
+void bidirectionalStep(CsrGraph & graph, Workspace & workspace, Workspace & other, long long & best) {
+  pair<int, int> min_node = heapDeleteMin(workspace.heap);
+  int node = min_node.first;
+  int node_value = min_node.second;
+  workspace.processed[node] = 1;
+
+  int edge_end = graph.offsets[node + 1];
+  for (int e = graph.offsets[node]; e < edge_end; e++) {
+    int edge_node = graph.targets[e];
+    int greedy_score = node_value + graph.lengths[e];
+    if (other.distances[edge_node] != INF_DIST) {
+      best = min(best, (long long) greedy_score + other.distances[edge_node]);
+    }
+    if (workspace.processed[edge_node]) continue;
+    if (greedy_score < workspace.distances[edge_node]) {
+      if (workspace.distances[edge_node] == INF_DIST) {
+	heapInsert(workspace.heap, edge_node, greedy_score);
+	workspace.touched.push_back(edge_node);
+      } else {
+	heapDecreaseKey(workspace.heap, edge_node, greedy_score);
+      }
+      workspace.distances[edge_node] = greedy_score;
+    }
+  }
+}
+
+/*
+ * Function: runQueries
+ * Usage: runQueries(graph, rgraph, queries, engine, report);
+ * ----------------------------------------------------------
+ * Answers the point-to-point queries with the given engine and prints
+ * one line per query. For engine "bidir" rgraph is the reverse graph,
+ * for engine "ch" graph and rgraph are the upward and downward graphs
+ * of a contraction hierarchy. If report is true the average time per
+ * query is written to std error.
+ */
+void runQueries(CsrGraph & graph, CsrGraph & rgraph, vector<pair<int, int> > & queries, string engine, bool report) {
+  Workspace forward, backward;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (size_t i = 0; i < queries.size(); i++) {
+    int source = queries[i].first;
+    int target = queries[i].second;
+    int distance;
+    if (engine == "ch") distance = hierarchyQuery(graph, rgraph, source, target, forward, backward);
+    else if (engine == "bidir") distance = bidirectional(graph, rgraph, source, target, forward, backward);
+    else distance = pointToPoint(graph, source, target, forward);
+    print(source, target, distance);
+  }
+  double elapsed = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+  if (report && !queries.empty()) {
+    cerr << "queries: " << queries.size() << " average: " << elapsed / queries.size() << " us" << endl;
+  }
+}
+
+/*
+ * Function: buildHierarchy
+ * Usage: CsrGraph up, down; buildHierarchy(graph, up, down);
+ * ----------------------------------------------------------
+ * Builds a contraction hierarchy of graph. The nodes are contracted one
+ * at a time in order of priority, smallest first. Contracting a node
+ * removes it from the remaining graph and adds a shortcut u -> w for each
+ * path u -> node -> w that is the only shortest path between u and w.
+ * Priorities are updated lazily: the extracted node is recomputed and
+ * put back if it is no longer the smallest.
+ * On return up holds, for each node, the edges and shortcuts to nodes
+ * contracted later, and down holds the reversed edges and shortcuts that
+ * come from nodes contracted later.
+ */
+void buildHierarchy(CsrGraph & graph, CsrGraph & up, CsrGraph & down) {
+  int graph_size = graph.present.size();
+  HierarchyBuilder builder;
+  builder.out.resize(graph_size);
+  builder.in.resize(graph_size);
+  builder.deleted_neighbors.assign(graph_size, 0);
+  builder.edge_slot.assign(graph_size, -1);
+  builder.marked = -1;
+  builder.hops.assign(graph_size, 0);
+  for (int v = 0; v < graph_size; v++) {
+    for (int e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+      if (graph.targets[e] != v) addShortcut(builder, v, graph.targets[e], graph.lengths[e]);
+    }
+  }
+
+  IndexedHeap queue;
+  queue.position.assign(graph_size, -1);
+  for (int v = 0; v < graph_size; v++) {
+    heapInsert(queue, v, nodePriority(builder, v));
+  }
+  while (!queue.nodes.empty()) {
+    int node = heapDeleteMin(queue).first;
+    int priority = nodePriority(builder, node);
+    if (!queue.nodes.empty() && priority > queue.nodes[0].second) {
+      heapInsert(queue, node, priority); // lazy update
+      continue;
+    }
+    contractNode(builder, node, false);
+    markEdges(builder, -1); // the lists are about to change
+    for (size_t i = 0; i < builder.out[node].size(); i++) {
+      removeEdge(builder.in[builder.out[node][i].first], node);
+    }
+    for (size_t i = 0; i < builder.in[node].size(); i++) {
+      removeEdge(builder.out[builder.in[node][i].first], node);
+    }
+    for (size_t i = 0; i < builder.out[node].size(); i++) builder.deleted_neighbors[builder.out[node][i].first]++;
+    for (size_t i = 0; i < builder.in[node].size(); i++) builder.deleted_neighbors[builder.in[node][i].first]++;
+  }
+
+  up.present = graph.present;
+  down.present = graph.present;
+  up.offsets.assign(graph_size + 1, 0);
+  down.offsets.assign(graph_size + 1, 0);
+  for (int v = 0; v < graph_size; v++) {
+    up.offsets[v + 1] = up.offsets[v] + builder.out[v].size();
+    for (size_t i = 0; i < builder.out[v].size(); i++) {
+      up.targets.push_back(builder.out[v][i].first);
+      up.lengths.push_back(builder.out[v][i].second);
+    }
+    down.offsets[v + 1] = down.offsets[v] + builder.in[v].size();
+    for (size_t i = 0; i < builder.in[v].size(); i++) {
+      down.targets.push_back(builder.in[v][i].first);
+      down.lengths.push_back(builder.in[v][i].second);
+    }
+  }
+}
+
+/*
+ * Function: nodePriority
+ * ----------------------
+ * Returns the contraction priority of a node: the number of shortcuts
+ * its contraction would add, minus the number of edges it would remove,
+ * plus the number of its neighbors already contracted, which spreads
+ * the contractions evenly over the graph.
+ */
+int nodePriority(HierarchyBuilder & builder, int node) {
+  int removed_edges = builder.out[node].size() + builder.in[node].size();
+  return contractNode(builder, node, true) - removed_edges + builder.deleted_neighbors[node];
+}
+
+/*
+ * Function: contractNode
+ * ----------------------
+ * Finds the shortcuts needed to contract node and returns their number.
+ * They are only added to the graph if simulate is false. For each
+ * in-neighbor u a witness search looks for paths from u that
+ * avoid node; a shortcut u -> w is needed when no such path is as short
+ * as the path through node.
+ */
+int contractNode(HierarchyBuilder & builder, int node, bool simulate) {
+  vector<pair<int, int> > & in = builder.in[node];
+  vector<pair<int, int> > & out = builder.out[node];
+  int shortcuts = 0;
+  for (size_t i = 0; i < in.size(); i++) {
+    int source = in[i].first;
+    int max_distance = -1;
+    for (size_t j = 0; j < out.size(); j++) {
+      int target = out[j].first;
+      if (target == source) continue;
+      max_distance = max(max_distance, in[i].second + out[j].second);
+    }
+    if (max_distance < 0) continue; // no remaining out-neighbors
+    witnessSearch(builder, source, node, max_distance, simulate ? SIMULATE_LIMIT : WITNESS_LIMIT,
+		  simulate ? SIMULATE_HOPS : WITNESS_HOPS);
+    for (size_t j = 0; j < out.size(); j++) {
+      int target = out[j].first;
+      if (target == source) continue;
+      int length = in[i].second + out[j].second;
+      if (builder.witness.distances[target] > length) {
+	shortcuts++;
+	if (!simulate) addShortcut(builder, source, target, length);
+      }
+    }
+  }
+  return shortcuts;
+}
+
+/*
+ * Function: witnessSearch
+ * -----------------------
+ * Runs Dijkstra from source on the remaining graph without the node
+ * skip, leaving the distances in builder.witness. The search stops at
+ * max_distance or after limit nodes and does not follow paths of more
+ * than max_hops edges; nodes it did not reach keep INF_DIST, which at
+ * worst adds an unnecessary shortcut.
+ */
+void witnessSearch(HierarchyBuilder & builder, int source, int skip, int max_distance, int limit, int max_hops) {
+  Workspace & workspace = builder.witness;
+  resetWorkspace(workspace, builder.out.size());
+  workspace.distances[source] = 0;
+  builder.hops[source] = 0;
+  workspace.touched.push_back(source);
+  heapInsert(workspace.heap, source, 0);
+  int settled = 0;
+  while (!workspace.heap.nodes.empty() && settled < limit) {
+    pair<int, int> min_node = heapDeleteMin(workspace.heap);
+    int node = min_node.first;
+    int node_value = min_node.second;
+    if (node_value > max_distance) break;
+    workspace.processed[node] = 1;
+    settled++;
+    if (builder.hops[node] == max_hops) continue;
+    vector<pair<int, int> > & edges = builder.out[node];
+    for (size_t i = 0; i < edges.size(); i++) {
+      int edge_node = edges[i].first;
+      if (edge_node == skip || workspace.processed[edge_node]) continue;
+      int greedy_score = node_value + edges[i].second;
+      if (greedy_score < workspace.distances[edge_node]) {
+	if (workspace.distances[edge_node] == INF_DIST) {
+	  heapInsert(workspace.heap, edge_node, greedy_score);
+	  workspace.touched.push_back(edge_node);
+	} else {
+	  heapDecreaseKey(workspace.heap, edge_node, greedy_score);
+	}
+	workspace.distances[edge_node] = greedy_score;
+	builder.hops[edge_node] = builder.hops[node] + 1;
+      }
+    }
+  }
+}
+
+/*
+ * Function: addShortcut
+ * ---------------------
+ * Adds the edge source -> target to the builder graph, or shortens the
+ * existing edge if the new length is smaller. The out edges of source
+ * are marked in edge_slot first, which costs one pass over them when
+ * the previous call was for another source and nothing afterwards.
+ */
+void addShortcut(HierarchyBuilder & builder, int source, int target, int length) {
+  markEdges(builder, source);
+  vector<pair<int, int> > & out = builder.out[source];
+  int slot = builder.edge_slot[target];
+  if (slot != -1) {
+    if (length < out[slot].second) {
+      out[slot].second = length;
+      vector<pair<int, int> > & in = builder.in[target];
+      for (size_t j = 0; j < in.size(); j++) {
+	if (in[j].first == source) in[j].second = length;
+      }
+    }
+    return;
+  }
+  builder.edge_slot[target] = out.size();
+  out.push_back(make_pair(target, length));
+  builder.in[target].push_back(make_pair(source, length));
+}
+
+/*
+ * Function: markEdges
+ * -------------------
+ * Points edge_slot at the out edges of source, clearing the marks of the
+ * previously marked node. markEdges(builder, -1) only clears, which must
+ * be done before edges are removed from the lists.
+ */
+void markEdges(HierarchyBuilder & builder, int source) {
+  if (builder.marked == source) return;
+  if (builder.marked != -1) {
+    vector<pair<int, int> > & old = builder.out[builder.marked];
+    for (size_t i = 0; i < old.size(); i++) builder.edge_slot[old[i].first] = -1;
+  }
+  builder.marked = source;
+  if (source == -1) return;
+  vector<pair<int, int> > & out = builder.out[source];
+  for (size_t i = 0; i < out.size(); i++) builder.edge_slot[out[i].first] = i;
+}
+
+void removeEdge(vector<pair<int, int> > & edges, int node) {
+  for (size_t i = 0; i < edges.size(); i++) {
+    if (edges[i].first == node) {
+      edges[i] = edges.back();
+      edges.pop_back();
+      return;
+    }
+  }
+}
+
+/*
+ * Function: hierarchyQuery
+ * Usage: int distance = hierarchyQuery(up, down, source, target, forward, backward);
+ * ---------------------------------------------------------------------------------
+ * Computes the distance from source to target in a contraction
+ * hierarchy. The forward search only follows up edges and the backward
+ * search only down edges, so both climb towards the nodes contracted
+ * last and together see only a small part of the graph. A direction
+ * stops when its heap minimum is no smaller than the best path found.
+ */
+int hierarchyQuery(CsrGraph & up, CsrGraph & down, int source, int target, Workspace & forward, Workspace & backward) {
+  int graph_size = up.present.size();
+  resetWorkspace(forward, graph_size);
+  resetWorkspace(backward, graph_size);
+  if (source < 0 || source >= graph_size || target < 0 || target >= graph_size) return INF_DIST;
+  if (source == target) return 0;
+
+  forward.distances[source] = 0;
+  forward.touched.push_back(source);
+  heapInsert(forward.heap, source, 0);
+  backward.distances[target] = 0;
+  backward.touched.push_back(target);
+  heapInsert(backward.heap, target, 0);
+
+  long long best = INF_DIST;
+  while (true) {
+    long long forward_min = forward.heap.nodes.empty() ? INF_DIST : forward.heap.nodes[0].second;
+    long long backward_min = backward.heap.nodes.empty() ? INF_DIST : backward.heap.nodes[0].second;
+    if (min(forward_min, backward_min) >= best) break;
+    if (forward_min <= backward_min) {
+      bidirectionalStep(up, forward, backward, best);
+    } else {
+      bidirectionalStep(down, backward, forward, best);
+    }
+  }
+  return best;
+}
+
+/*
+ * Function: writeHierarchy
+ * Usage: writeHierarchy(up, down, filename);
+ * ------------------------------------------
+ * Writes a contraction hierarchy to a binary file: the HIERARCHY_MAGIC
+ * bytes, the node count, the present flags and then the offsets,
+ * targets and lengths of up and of down, each vector preceded by its
+ * size. Returns false if the file cannot be written.
+ */
+bool writeHierarchy(CsrGraph & up, CsrGraph & down, string filename) {
+  ofstream outfile(filename.c_str(), ios::binary);
+  if (outfile.fail()) return false;
+  outfile.write(HIERARCHY_MAGIC, sizeof HIERARCHY_MAGIC);
+  int graph_size = up.present.size();
+  outfile.write((char *) &graph_size, sizeof graph_size);
+  if (graph_size > 0) outfile.write(&up.present[0], graph_size);
+  writeVector(outfile, up.offsets);
+  writeVector(outfile, up.targets);
+  writeVector(outfile, up.lengths);
+  writeVector(outfile, down.offsets);
+  writeVector(outfile, down.targets);
+  writeVector(outfile, down.lengths);
+  return !outfile.fail();
+}
+
+bool readHierarchy(CsrGraph & up, CsrGraph & down, string filename) {
+  ifstream chfile(filename.c_str(), ios::binary);
+  char magic[sizeof HIERARCHY_MAGIC];
+  if (!chfile.read(magic, sizeof magic) || memcmp(magic, HIERARCHY_MAGIC, sizeof magic) != 0) return false;
+  int graph_size;
+  if (!chfile.read((char *) &graph_size, sizeof graph_size) || graph_size < 0) return false;
+  up.present.resize(graph_size);
+  if (graph_size > 0 && !chfile.read(&up.present[0], graph_size)) return false;
+  down.present = up.present;
+  return readVector(chfile, up.offsets) && readVector(chfile, up.targets) && readVector(chfile, up.lengths) &&
+    readVector(chfile, down.offsets) && readVector(chfile, down.targets) && readVector(chfile, down.lengths) &&
+    validHierarchyGraph(up, graph_size) && validHierarchyGraph(down, graph_size);
+}
+
+/*
+ * Function: validHierarchyGraph
+ * -----------------------------
+ * Checks that a graph read from a hierarchy file can be searched: the
+ * offsets start at 0, never decrease and end at the number of targets,
+ * every target is a node below graph_size and every edge has a length.
+ */
+bool validHierarchyGraph(CsrGraph & graph, int graph_size) {
+  if ((int) graph.offsets.size() != graph_size + 1 || graph.offsets[0] != 0) return false;
+  for (int node = 0; node < graph_size; node++) {
+    if (graph.offsets[node + 1] < graph.offsets[node]) return false;
+  }
+  if ((size_t) graph.offsets[graph_size] != graph.targets.size() || graph.lengths.size() != graph.targets.size()) return false;
+  for (size_t i = 0; i < graph.targets.size(); i++) {
+    if (graph.targets[i] < 0 || graph.targets[i] >= graph_size) return false;
+  }
+  return true;
+}
+
+void writeVector(ofstream & outfile, vector<int> & vec) {
+  long long size = vec.size();
+  outfile.write((char *) &size, sizeof size);
+  if (size > 0) outfile.write((char *) &vec[0], size * sizeof(int));
+}
+
+bool readVector(ifstream & infile, vector<int> & vec) {
+  long long size;
+  if (!infile.read((char *) &size, sizeof size) || size < 0) return false;
+  vec.resize(size);
+  return size == 0 || infile.read((char *) &vec[0], size * sizeof(int));
+}
+
+/*
+ * Function: resetWorkspace
+ * ------------------------
+ * Prepares a workspace for a point-to-point query. The buffers are
+ * allocated on first use; after that only the nodes in touched are reset
+ * and the nodes left on the heap by an early exit are dropped.
+ */
+void resetWorkspace(Workspace & workspace, int graph_size) {
+  if ((int) workspace.distances.size() != graph_size) {
+    workspace.distances.assign(graph_size, INF_DIST);
+    workspace.processed.assign(graph_size, 0);
+    workspace.heap.position.assign(graph_size, -1);
+    workspace.heap.nodes.clear();
+    workspace.touched.clear();
+    return;
+  }
+  for (size_t i = 0; i < workspace.touched.size(); i++) {
+    int node = workspace.touched[i];
+    workspace.distances[node] = INF_DIST;
+    workspace.processed[node] = 0;
+    workspace.heap.position[node] = -1;
+  }
+  workspace.heap.nodes.clear();
+  workspace.touched.clear();
+}
+
+/*
+ * Function: reverseGraph
+ * Usage: CsrGraph rgraph; reverseGraph(graph, rgraph);
+ * ----------------------------------------------------
+ * Builds the CSR graph with all edges of graph reversed.
+ */
+void reverseGraph(CsrGraph & graph, CsrGraph & rgraph) {
+  int graph_size = graph.present.size();
+  int edge_count = graph.targets.size();
+  rgraph.present = graph.present;
+  rgraph.offsets.assign(graph_size + 1, 0);
+  for (int e = 0; e < edge_count; e++) rgraph.offsets[graph.targets[e] + 1]++;
+  for (int v = 0; v < graph_size; v++) rgraph.offsets[v + 1] += rgraph.offsets[v];
+
+  vector<int> next(rgraph.offsets.begin(), rgraph.offsets.end() - 1);
+  rgraph.targets.resize(edge_count);
+  rgraph.lengths.resize(edge_count);
+  for (int v = 0; v < graph_size; v++) {
+    for (int e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+      int slot = next[graph.targets[e]]++;
+      rgraph.targets[slot] = v;
+      rgraph.lengths[slot] = graph.lengths[e];
+    }
+  }
+}
+
+/*
+ * Function: readQueries
+ * Usage: vector<pair<int, int> > queries; readQueries(queries, filename);
+ * -----------------------------------------------------------------------
+ * Reads "source target" pairs from the named file.
+ * Returns false if the file cannot be opened.
+ */
+bool readQueries(vector<pair<int, int> > & queries, string filename) {
+  ifstream queryfile(filename.c_str());
+  if (queryfile.fail()) return false;
+  int source, target;
+  while (queryfile >> source >> target) {
+    queries.push_back(make_pair(source, target));
+  }
+  return true;
+}
+
+
 /*
  * Function: readFile
  * Usage: map<int, vector<int> > graph; readFile(graph);
@@ -282,6 +1879,10 @@ void readFile(map<int, set<pair<int, int> > > & graph, ifstream & infile) {
     set<pair<int, int> > row;
     while(stream >> target_edge) { // target nodes with edge lengths
       di = target_edge.find(",");
+      if (di == (int) string::npos) { // no length, as the CSR parser skips it
+	cout << "Warning: edge without length" << endl;
+	continue;
+      }
       target_node = stringToInteger(target_edge.substr(0, di));
       edge_length = stringToInteger(target_edge.substr(di + 1));
       if (target_node <= maxNodes) {
@@ -299,6 +1900,281 @@ void readFile(map<int, set<pair<int, int> > > & graph, ifstream & infile) {
   infile.close();
 }
 
+/*
+ * Function: readFile
+ * Usage: CsrGraph graph; readFile(graph, filename, threads);
+ * ----------------------------------------------------------
+ * Reads the same adjacency list file into a compressed sparse row graph.
+ * The file is mapped into memory and split into one chunk per thread at
+ * line boundaries. The threads parse their chunks twice: the first pass
+ * only counts the edges of each row, which gives the CSR offsets and the
+ * slot of every row, and the second pass writes the edges straight into
+ * their slots. No memory is allocated per edge or per line.
+ * Graph snapshots are handed to readSnapshot.
+ * Returns false if the file cannot be read.
+ */
+bool readFile(CsrGraph & graph, string filename, int threads) {
+  if (isSnapshot(filename)) return readSnapshot(graph, filename);
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) < 0) {
+    close(fd);
+    return false;
+  }
+  size_t size = file_stat.st_size;
+  const char * data = NULL;
+  if (size > 0) {
+    void * mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    data = (const char *) mapped;
+    madvise(mapped, size, MADV_SEQUENTIAL);
+  }
+  close(fd);
+
+  threads = max(1, (int) min((size_t) threads, size)); // no empty chunks
+  vector<ParseChunk> chunks(threads);
+  const char * chunk_begin = data;
+  for (int i = 0; i < threads; i++) {
+    const char * chunk_end = data + size;
+    if (i < threads - 1) {
+      chunk_end = max(chunk_begin, data + size * (i + 1) / threads);
+      while (chunk_end > data && chunk_end < data + size && *(chunk_end - 1) != '\n') chunk_end++;
+    }
+    chunks[i].begin = chunk_begin;
+    chunks[i].end = chunk_end;
+    chunks[i].max_node = 0;
+    chunks[i].skipped = 0;
+    chunk_begin = chunk_end;
+  }
+
+  vector<thread> workers;
+  for (int i = 1; i < threads; i++) workers.push_back(thread(parseChunk, ref(chunks[i]), (CsrGraph *) NULL));
+  parseChunk(chunks[0], NULL);
+  for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+
+  int max_node = 0, skipped = 0;
+  for (int i = 0; i < threads; i++) {
+    max_node = max(max_node, chunks[i].max_node);
+    skipped += chunks[i].skipped;
+  }
+  if (skipped > 0) {
+    cout << "Warning: node number exceeded max nodes or malformed number (" << skipped << " times)" << endl;
+  }
+  int graph_size = max_node + 1;
+  graph.present.assign(graph_size, 0);
+  graph.offsets.assign(graph_size + 1, 0);
+  for (int i = 0; i < threads; i++) {
+    vector<pair<int, int> > & rows = chunks[i].rows;
+    for (size_t r = 0; r < rows.size(); r++) {
+      graph.present[rows[r].first] = 1;
+      graph.offsets[rows[r].first + 1] += rows[r].second;
+    }
+  }
+  for (int v = 0; v < graph_size; v++) graph.offsets[v + 1] += graph.offsets[v];
+  vector<int> next(graph.offsets.begin(), graph.offsets.end() - 1); // next free slot per row
+  for (int i = 0; i < threads; i++) {
+    vector<pair<int, int> > & rows = chunks[i].rows;
+    chunks[i].row_starts.resize(rows.size());
+    for (size_t r = 0; r < rows.size(); r++) {
+      chunks[i].row_starts[r] = next[rows[r].first];
+      next[rows[r].first] += rows[r].second;
+    }
+  }
+  graph.targets.resize(graph.offsets[graph_size]);
+  graph.lengths.resize(graph.offsets[graph_size]);
+
+  workers.clear();
+  for (int i = 1; i < threads; i++) workers.push_back(thread(parseChunk, ref(chunks[i]), &graph));
+  parseChunk(chunks[0], &graph);
+  for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+
+  if (size > 0) munmap((void *) data, size);
+  return true;
+}
+
+/*
+ * Function: readSnapshot
+ * Usage: CsrGraph graph; readSnapshot(graph, filename);
+ * -----------------------------------------------------
+ * Fills a CSR graph from a mapped graph snapshot. The snapshot arrays
+ * are copied as they are unless nodes above maxNodes have to be dropped.
+ * Returns false if the file is not a valid snapshot or has more nodes or
+ * edges than the int offsets of a CsrGraph can hold.
+ */
+bool readSnapshot(CsrGraph & graph, string filename) {
+  GraphSnapshot snapshot;
+  if (!openSnapshot(snapshot, filename)) return false;
+  if (!snapshotFitsInt(snapshot)) {
+    closeSnapshot(snapshot);
+    return false;
+  }
+  int graph_size = min(snapshot.nodes, (long long) maxNodes + 1);
+  graph.present.assign(snapshot.present, snapshot.present + graph_size);
+  graph.offsets.assign(graph_size + 1, 0);
+  graph.targets.clear();
+  graph.lengths.clear();
+  int skipped = 0;
+  if (graph_size == snapshot.nodes) {
+    graph.offsets.assign(snapshot.offsets, snapshot.offsets + graph_size + 1);
+    graph.targets.assign(snapshot.targets, snapshot.targets + snapshot.edges);
+    if (snapshot.weights != NULL) graph.lengths.assign(snapshot.weights, snapshot.weights + snapshot.edges);
+    else graph.lengths.assign(snapshot.edges, 1);
+  } else {
+    for (long long v = 0; v < snapshot.nodes; v++) {
+      if (v >= graph_size) {
+	skipped += snapshot.present[v];
+	continue;
+      }
+      for (long long e = snapshot.offsets[v]; e < snapshot.offsets[v + 1]; e++) {
+	if (snapshot.targets[e] > maxNodes) {
+	  skipped++;
+	  continue;
+	}
+	graph.targets.push_back(snapshot.targets[e]);
+	graph.lengths.push_back(snapshot.weights != NULL ? snapshot.weights[e] : 1);
+      }
+      graph.offsets[v + 1] = graph.targets.size();
+    }
+  }
+  closeSnapshot(snapshot);
+  if (skipped > 0) {
+    cout << "Warning: node number exceeded max nodes (" << skipped << " times)" << endl;
+  }
+  return true;
+}
+
+/*
+ * Function: readSnapshot
+ * Usage: map<int, set<pair<int, int> > > graph; readSnapshot(graph, filename);
+ * ----------------------------------------------------------------------------
+ * Fills the map of sets used by the heap engine from a graph snapshot,
+ * with the same handling of maxNodes as readFile.
+ */
+bool readSnapshot(map<int, set<pair<int, int> > > & graph, string filename) {
+  GraphSnapshot snapshot;
+  if (!openSnapshot(snapshot, filename)) return false;
+  for (long long v = 0; v < snapshot.nodes; v++) {
+    if (!snapshot.present[v]) continue;
+    set<pair<int, int> > row;
+    for (long long e = snapshot.offsets[v]; e < snapshot.offsets[v + 1]; e++) {
+      if (snapshot.targets[e] <= maxNodes) {
+	row.insert(make_pair(snapshot.targets[e], snapshot.weights != NULL ? snapshot.weights[e] : 1));
+      } else {
+	cout << "Warning: node number exceeded max nodes" << endl;
+      }
+    }
+    if (v <= maxNodes) {
+      graph[v] = row;
+    } else {
+      cout << "Warning: node number exceeded max nodes" << endl;
+    }
+  }
+  closeSnapshot(snapshot);
+  return true;
+}
+
+/*
+ * Function: parseChunk
+ * Usage: parseChunk(chunk, NULL); parseChunk(chunk, &graph);
+ * ----------------------------------------------------------
+ * Parses the rows "node target,length target,length ..." of a chunk.
+ * Without a graph it records the node and edge count of every row along
+ * with the largest node number; with a graph it writes the edges of each
+ * row to the CSR slots starting at its row_starts entry. Rows and edges
+ * with node numbers above maxNodes are skipped in both passes, and so
+ * are rows with a malformed node number and edges with a malformed
+ * target or length: one with a minus sign, other characters than digits
+ * or a number too large for an int. An edge without its ",length" part
+ * is malformed too.
+ */
+void parseChunk(ParseChunk & chunk, CsrGraph * graph) {
+  const char * p = chunk.begin;
+  const char * end = chunk.end;
+  size_t row = 0;
+  while (p < end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    if (p == end) break;
+    if (*p == '\n') { // empty line
+      p++;
+      continue;
+    }
+    int node;
+    p = parseInteger(p, end, node);
+    if (node < 0 || !(p == end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+      while (p < end && *p != '\n') p++;
+      p++;
+      if (graph == NULL) chunk.skipped++;
+      continue;
+    }
+    bool keep = node <= maxNodes;
+    int slot = graph != NULL && keep ? chunk.row_starts[row] : 0;
+    int count = 0;
+    while (p < end && *p != '\n') {
+      if (*p == ' ' || *p == '\t' || *p == '\r') { // separator
+	p++;
+	continue;
+      }
+      int target_node, edge_length = -1; // stays -1 without ",length"
+      p = parseInteger(p, end, target_node);
+      if (target_node >= 0 && p < end && *p == ',') p = parseInteger(p + 1, end, edge_length);
+      if (target_node < 0 || edge_length < 0 ||
+	  !(p == end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+	if (keep && graph == NULL) chunk.skipped++;
+	continue;
+      }
+      if (!keep) continue;
+      if (target_node > maxNodes) {
+	if (graph == NULL) chunk.skipped++;
+	continue;
+      }
+      if (graph != NULL) {
+	graph -> targets[slot] = target_node;
+	graph -> lengths[slot] = edge_length;
+	slot++;
+      } else {
+	count++;
+	chunk.max_node = max(chunk.max_node, target_node);
+      }
+    }
+    p++; // the newline
+    if (!keep) {
+      if (graph == NULL) chunk.skipped++;
+      continue;
+    }
+    if (graph == NULL) {
+      chunk.rows.push_back(make_pair(node, count));
+      chunk.max_node = max(chunk.max_node, node);
+    }
+    row++;
+  }
+}
+
+/*
+ * Function: parseInteger
+ * ----------------------
+ * Reads the decimal digits starting at p into value and returns the
+ * position after the last digit. value is -1 if there is no digit at p
+ * or the number does not fit into an int.
+ */
+const char * parseInteger(const char * p, const char * end, int & value) {
+  if (p == end || *p < '0' || *p > '9') {
+    value = -1;
+    return p;
+  }
+  long long result = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    if (result <= INF_DIST) result = result * 10 + (*p - '0');
+    p++;
+  }
+  value = result <= INF_DIST ? result : -1;
+  return p;
+}
+
 /*
  * Function: print
  * Usage: vector<int> vec; print(vec);
@@ -363,6 +2239,27 @@ void print(map<int, int> & distances, map<int, list<int> > & pathmap) {
   }
 }
 
+/*
+ * Function: print
+ * Usage: print(graph, distances);
+ * -------------------------------
+ * Prints the distances computed on a CSR graph in the same format as
+ * print(distances, pathmap), one line per node that has a row in the
+ * input file. Unreachable nodes are reported with distance MAX_DIST.
+ */
+void print(CsrGraph & graph, vector<int> & distances) {
+  int graph_size = graph.present.size();
+  for (int v = 0; v < graph_size; v++) {
+    if (!graph.present[v]) continue;
+    int path_length = distances[v] == INF_DIST ? MAX_DIST : distances[v];
+    cout << v << " => " << path_length << " []" << endl;
+  }
+}
+
+void print(int source, int target, int distance) {
+  cout << source << " " << target << " => " << (distance == INF_DIST ? MAX_DIST : distance) << endl;
+}
+
 /*
  * Function: promptUserForFile
  * Usage: string filename = promptUserForFile(infile, prompt);
@@ -394,8 +2291,8 @@ bool testFileName(ifstream & infile, string filename) {
 int stringToInteger(string str) {
   istringstream stream(str);
   int value;
-  stream >> value >> ws;
-  if (stream.fail() || !stream.eof()) {
+  stream >> value;
+  if (stream.fail() || !(stream >> ws).eof()) {
     cerr << "stringToInteger: Illegal integer format (" + str + ")";
     return 1;
   }
@@ -5,12 +5,27 @@
  * algorithm based on merge sort idea. It reads integers from a file
  * specified as the first argument of the program or prompted for
  * and writes the result to std output.
+ *
+ * An optional MODE argument after the file name selects the engine:
+ *   merge - merge sort that counts the split inversions (default)
+ *   radix - ranks the numbers with an LSD radix sort (see
+ *           ../radix/RadixSort.h) and counts the inversions with a
+ *           Fenwick tree over the ranks
+ *   bench [SIZE]
+ *         - times both engines on the numbers of the file or on SIZE
+ *           random numbers
+ * Like the merge engine, the radix engine counts pairs of equal numbers
+ * as inversions.
  */
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
+#include <random>
+#include <chrono>
+#include "../radix/RadixSort.h"
 using namespace std;
 
 /* Function prototypes */
@@ -21,6 +36,10 @@ unsigned long mergeAndCount(vector<long> & vec, vector<long> & vec1, vector<long
 bool testFileName(ifstream & infile, string filename);
 void readFile(vector<long> & vec, ifstream & infile);
 void print(vector<long> & vec);
+unsigned long countInvRadix(vector<long> & vec);
+void benchmark(vector<long> & numbers);
+void randomNumbers(vector<long> & vec, long size);
+long stringToLong(string str);
 
 /* Main program */
 
@@ -29,6 +48,13 @@ using namespace std;
 int main(int argc, char* argv[]) {
   vector<long> in_numbers;
   ifstream infile;
+  string mode = argc > 2 ? argv[2] : "merge";
+  if (mode != "merge" && mode != "radix" && mode != "bench") {
+    cerr << "Unknown mode: " << mode << "\n"
+	 << "Usage: " << argv[0] << " FILENAME [merge|radix]\n"
+	 << "       " << argv[0] << " FILENAME bench [SIZE]" << endl;
+    return 1;
+  }
   if (argc < 2) {
     promptUserForFile(infile, "Input file: ");
   }
@@ -40,7 +66,12 @@ int main(int argc, char* argv[]) {
     }
   }
   readFile(in_numbers, infile);
-  cout << countInv(in_numbers) << endl;
+  if (mode == "bench") {
+    if (argc > 3) randomNumbers(in_numbers, stringToLong(argv[3]));
+    benchmark(in_numbers);
+  }
+  else if (mode == "radix") cout << countInvRadix(in_numbers) << endl;
+  else cout << countInv(in_numbers) << endl;
   return 0;
 }
 
@@ -104,6 +135,70 @@ unsigned long mergeAndCount(vector<long> & vec, vector<long> & vec1, vector<long
   return count;
 }
 
+/*
+ * Function: countInvRadix
+ * -----------------------
+ * This function counts the inversions of the numbers in the vector
+ * without sorting it by comparisons:
+ *
+ * 1. Replace every number by its rank among the distinct numbers with
+ *    radixRanks.
+ * 2. Go through the ranks from left to right, keeping a Fenwick tree
+ *    (binary indexed tree) with the count of every rank seen so far.
+ *    The numbers seen before the current one that are not smaller form
+ *    inversions with it: all i seen numbers minus those with a smaller
+ *    rank, a prefix sum of the tree.
+ */
+unsigned long countInvRadix(vector<long> & vec) {
+  vector<int> ranks;
+  int distinct = radixRanks(vec, ranks);
+  vector<int> tree(distinct + 1);
+  unsigned long count = 0;
+  long n = vec.size();
+  for (long i = 0; i < n; i++) {
+    long smaller = 0;
+    for (int r = ranks[i] - 1; r > 0; r -= r & -r) smaller += tree[r];
+    count += i - smaller;
+    for (int r = ranks[i]; r <= distinct; r += r & -r) tree[r]++;
+  }
+  return count;
+}
+
+/*
+ * Function: benchmark
+ * Usage: benchmark(numbers);
+ * --------------------------
+ * Counts the inversions of copies of numbers with countInv and with
+ * countInvRadix and prints the time of each and whether they differ.
+ */
+void benchmark(vector<long> & numbers) {
+  typedef chrono::steady_clock Clock;
+  cout << "numbers: " << numbers.size() << endl;
+  vector<long> vec(numbers);
+  Clock::time_point start = Clock::now();
+  unsigned long expected = countInv(vec);
+  double merge_time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "merge: " << merge_time << " s, " << expected << " inversions" << endl;
+
+  vec = numbers;
+  start = Clock::now();
+  unsigned long count = countInvRadix(vec);
+  double time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "radix: " << time << " s, speedup " << merge_time / time
+       << (count == expected ? "" : " MISMATCH") << endl;
+}
+
+/*
+ * Function: randomNumbers
+ * -----------------------
+ * Fills vec with size random numbers from a fixed seed.
+ */
+void randomNumbers(vector<long> & vec, long size) {
+  mt19937_64 generator(size);
+  vec.resize(size);
+  for (long i = 0; i < size; i++) vec[i] = generator();
+}
+
 /*
  * Function: readFile
  * Usage: vector<int> vec; readFile(vec);
@@ -111,7 +206,7 @@ unsigned long mergeAndCount(vector<long> & vec, vector<long> & vec1, vector<long
  * Asks for a file with numbers and reads the numbers into the vector;
  */
 void readFile(vector<long> & vec, ifstream & infile) {
-  int value;
+  long value;
   while (infile >> value) {
     vec.push_back(value);
   }
@@ -158,3 +253,14 @@ bool testFileName(ifstream & infile, string filename) {
   infile.open(filename.c_str());
   return !infile.fail();
 }
+
+long stringToLong(string str) {
+  istringstream stream(str);
+  long value;
+  stream >> value;
+  if (stream.fail() || !(stream >> ws).eof()) {
+    cerr << "stringToLong: Illegal integer format (" + str + ")";
+    return 0;
+  }
+  return value;
+}
@@ -4,14 +4,133 @@
  * This program is an implementation of the merge sort
  * algorithm. It reads characters from std input
  * and writes the sorted result to std output.
+ *
+ * An optional MODE argument after the file name selects the sort:
+ *   recursive - top-down merge sort on fresh vectors (default)
+ *   bottomup  - bottom-up merge sort that insertion sorts runs of
+ *               RUN_SIZE elements and then merges runs of doubling width
+ *               back and forth between the vector and one scratch buffer
+ *   bench [SIZE]
+ *             - times both sorts and counts their heap allocations, on
+ *               the numbers of the file or on SIZE random numbers
+ *   parallel [THREADS]
+ *             - bottomup on THREADS threads (default: one per core):
+ *               every thread sorts one chunk of the vector, then the
+ *               chunks are merged level by level, and every merge level
+ *               is split among all threads by merge path
+ *   scaling [MAX_THREADS [SIZE]]
+ *             - times parallel with 1, 2, 4, ... MAX_THREADS threads
+ *               against bottomup, on the numbers of the file or on SIZE
+ *               random numbers
+ *   external [MEMORY_MB [OUTFILE]]
+ *             - sorts files larger than the memory: the file is read in
+ *               runs of MEMORY_MB megabytes (default 1024) of longs,
+ *               each run is sorted and spilled to a temporary file in
+ *               $TMPDIR (default /tmp), and the runs are merged with a
+ *               loser tree. Writes the result to OUTFILE or std output
+ *   radix     - LSD radix sort, see ../radix/RadixSort.h
+ *   radixbench [SIZE]
+ *             - times the recursive, bottomup and radix sorts on the
+ *               numbers of the file or on SIZE random numbers
  */
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
+#include <random>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "../radix/RadixSort.h"
 using namespace std;
 
+const int RUN_SIZE = 32; // bottomup insertion sorts runs of this size
+const int MAX_FAN_IN = 256; // runs external merges at a time
+const size_t MIN_IO_BUFFER = 1 << 20; // bytes, smallest buffer per file
+
+/*
+ * Type: IoBuffer
+ * --------------
+ * A large buffer between a file and the program, so that the file is
+ * read or written in big sequential blocks: data[pos .. size - 1] is
+ * what is left to read, or data[0 .. pos - 1] what is waiting to be
+ * written.
+ */
+struct IoBuffer {
+  FILE * file;
+  vector<char> data;
+  size_t pos;
+  size_t size;
+};
+
+/*
+ * Type: LoserTree
+ * ---------------
+ * A tournament tree over the heads of k sorted runs. tree[1 .. k - 1]
+ * are the internal nodes, each holding the run that lost the match
+ * there, and tree[0] holds the overall winner, the run with the
+ * smallest head. The run of leaf i sits below node (i + k) / 2. A run
+ * that is used up has done[i] set and loses every match.
+ */
+struct LoserTree {
+  int k;
+  vector<int> tree;
+  vector<long> heads;
+  vector<char> done;
+};
+
+/*
+ * Type: ParallelMerge
+ * -------------------
+ * The state shared by the threads of the parallel sort. In the first
+ * step every thread sorts chunk elements of src with the same part of
+ * dst as scratch. In every later step the runs of width elements in src
+ * are merged in pairs into dst, and thread id writes the output slots
+ * id * n / threads to (id + 1) * n / threads - 1.
+ */
+struct ParallelMerge {
+  int * src;
+  int * dst;
+  long n;
+  long chunk;
+  long width;
+  int threads;
+};
+
+/*
+ * The global operator new is replaced to count the heap allocations of
+ * the program, which the bench mode reports for each sort. The delete
+ * operators are not inlined, where g++ would take the malloc and free
+ * pair for a mismatch with new.
+ */
+atomic<long> allocations(0);
+atomic<long> allocated_bytes(0);
+
+void * operator new(size_t size) {
+  allocations++;
+  allocated_bytes += size;
+  void * p = malloc(size == 0 ? 1 : size);
+  if (p == NULL) throw bad_alloc();
+  return p;
+}
+
+__attribute__((noinline)) void operator delete(void * p) noexcept {
+  free(p);
+}
+
+__attribute__((noinline)) void operator delete(void * p, size_t) noexcept {
+  free(p);
+}
+
 /* Function prototypes */
 
 string promptUserForFile(ifstream & infile, string prompt);
@@ -20,6 +139,32 @@ void merge(vector<int> & vec, vector<int> & vec1, vector<int> & vec2);
 bool testFileName(ifstream & infile, string filename);
 void readFile(vector<int> & vec, ifstream & infile);
 void print(vector<int> & vec);
+void bottomUpSort(vector<int> & vec);
+int * bottomUpSort(int * data, int * scratch, long n);
+void insertionSort(int * data, long start, long end);
+void mergeRuns(const int * src, int * dst, long start, long middle, long end);
+void parallelSort(vector<int> & vec, int threads);
+void chunkWorker(ParallelMerge & state, int id);
+void mergeWorker(ParallelMerge & state, int id);
+long coRank(long k, const int * a, long size_a, const int * b, long size_b);
+void scalingBenchmark(vector<int> & numbers, int max_threads);
+void benchmark(vector<int> & numbers);
+void radixBenchmark(vector<int> & numbers);
+void randomNumbers(vector<int> & vec, int size);
+int stringToInteger(string str);
+bool externalSort(FILE * in, FILE * out, long memory);
+void makeRuns(IoBuffer & input, long run_size, vector<FILE *> & runs, long & skipped);
+FILE * tempFile();
+void closeRuns(vector<FILE *> & runs, size_t first);
+FILE * mergeRunFiles(vector<FILE *> & runs, int first, int last, long memory, FILE * out, bool text);
+bool readNumber(IoBuffer & input, long & value, long & skipped);
+bool readLong(IoBuffer & input, long & value);
+bool writeBytes(IoBuffer & output, const void * bytes, size_t size);
+bool writeNumber(IoBuffer & output, long value);
+bool flushBuffer(IoBuffer & output);
+void buildLoserTree(LoserTree & lt);
+void replayLoserTree(LoserTree & lt, int leaf);
+bool beats(LoserTree & lt, int a, int b);
 
 /* Main program */
 
@@ -28,18 +173,69 @@ using namespace std;
 int main(int argc, char* argv[]) {
   vector<int> in_numbers;
   ifstream infile;
+  string filename;
+  string mode = argc > 2 ? argv[2] : "recursive";
+  if (mode != "recursive" && mode != "bottomup" && mode != "bench" &&
+      mode != "parallel" && mode != "scaling" && mode != "external" &&
+      mode != "radix" && mode != "radixbench") {
+    cerr << "Unknown mode: " << mode << "\n"
+	 << "Usage: " << argv[0] << " FILENAME [recursive|bottomup|radix]\n"
+	 << "       " << argv[0] << " FILENAME bench|radixbench [SIZE]\n"
+	 << "       " << argv[0] << " FILENAME parallel [THREADS]\n"
+	 << "       " << argv[0] << " FILENAME scaling [MAX_THREADS [SIZE]]\n"
+	 << "       " << argv[0] << " FILENAME external [MEMORY_MB [OUTFILE]]" << endl;
+    return 1;
+  }
   if (argc < 2) {
-    promptUserForFile(infile, "Input file: ");
+    filename = promptUserForFile(infile, "Input file: ");
   }
   else {
-    if (!testFileName(infile, argv[1])) {
+    filename = argv[1];
+    if (!testFileName(infile, filename)) {
       cerr << "No such file\n"
 	   <<"Usage: " << argv[0] << " FILENAME" << endl;
       return 1;
     }
   }
+  if (mode == "external") {
+    infile.close();
+    long memory = (argc > 3 ? stringToInteger(argv[3]) : 1024) * (1L << 20);
+    FILE * in = fopen(filename.c_str(), "rb");
+    FILE * out = argc > 4 ? fopen(argv[4], "wb") : stdout;
+    if (in == NULL || out == NULL) {
+      cerr << "Unable to open " << (in == NULL ? filename : argv[4]) << endl;
+      return 1;
+    }
+    bool ok = externalSort(in, out, max(memory, 1L << 20));
+    fclose(in);
+    if (fclose(out) != 0 || !ok) {
+      cerr << "Unable to write the result or a temporary file" << endl;
+      return 1;
+    }
+    return 0;
+  }
   readFile(in_numbers, infile);
-  sort(in_numbers);
+  if (mode == "bench") {
+    if (argc > 3) randomNumbers(in_numbers, stringToInteger(argv[3]));
+    benchmark(in_numbers);
+    return 0;
+  }
+  if (mode == "radixbench") {
+    if (argc > 3) randomNumbers(in_numbers, stringToInteger(argv[3]));
+    radixBenchmark(in_numbers);
+    return 0;
+  }
+  int threads = argc > 3 ? stringToInteger(argv[3]) : thread::hardware_concurrency();
+  threads = max(threads, 1);
+  if (mode == "scaling") {
+    if (argc > 4) randomNumbers(in_numbers, stringToInteger(argv[4]));
+    scalingBenchmark(in_numbers, threads);
+    return 0;
+  }
+  if (mode == "parallel") parallelSort(in_numbers, threads);
+  else if (mode == "bottomup") bottomUpSort(in_numbers);
+  else if (mode == "radix") radixSort(in_numbers);
+  else sort(in_numbers);
   print(in_numbers);
   return 0;
 }
@@ -95,6 +291,599 @@ void merge(vector<int> & vec, vector<int> & vec1, vector<int> & vec2) {
   while (n2 < vec2size) vec.push_back(vec2[n2++]);
 }
 
+/*
+ * Function: bottomUpSort
+ * Usage: bottomUpSort(vec);
+ * -------------------------
+ * Sorts the elements of the vector into increasing order without
+ * recursion and with a single allocation:
+ *
+ * 1. Insertion sort every run of RUN_SIZE elements in place.
+ * 2. Merge neighbouring runs of width 32, 64, 128, ... from one of vec
+ *    and a scratch buffer of the same size into the other, until one
+ *    run covers the whole vector.
+ * 3. If the last pass wrote to the scratch buffer, swap it with vec.
+ *
+ * The second form sorts the n elements of data with the n elements of
+ * scratch and returns the one of the two that holds the result.
+ */
+void bottomUpSort(vector<int> & vec) {
+  long n = vec.size();
+  if (n <= RUN_SIZE) {
+    insertionSort(&vec[0], 0, n - 1);
+    return;
+  }
+  vector<int> scratch(n);
+  if (bottomUpSort(&vec[0], &scratch[0], n) != &vec[0]) vec.swap(scratch);
+}
+
+int * bottomUpSort(int * data, int * scratch, long n) {
+  for (long start = 0; start < n; start += RUN_SIZE) {
+    insertionSort(data, start, min(start + RUN_SIZE, n) - 1);
+  }
+  int * src = data;
+  int * dst = scratch;
+  // long, as width * 2 and start + 2 * width pass 2^31 once n > 2^30
+  for (long width = RUN_SIZE; width < n; width *= 2) {
+    for (long start = 0; start < n; start += 2 * width) {
+      long middle = min(start + width, n);
+      long end = min(start + 2 * width, n);
+      mergeRuns(src, dst, start, middle, end);
+    }
+    swap(src, dst);
+  }
+  return src;
+}
+
+/*
+ * Function: insertionSort
+ * -----------------------
+ * Sorts the elements between start and end inclusive by inserting each
+ * element into the sorted part before it.
+ */
+void insertionSort(int * data, long start, long end) {
+  for (long i = start + 1; i <= end; i++) {
+    int value = data[i];
+    long j = i - 1;
+    while (j >= start && data[j] > value) {
+      data[j + 1] = data[j];
+      j--;
+    }
+    data[j + 1] = value;
+  }
+}
+
+/*
+ * Function: mergeRuns
+ * -------------------
+ * Merges the sorted runs src[start .. middle - 1] and src[middle .. end - 1]
+ * into dst[start .. end - 1]. A run without a partner is copied.
+ */
+void mergeRuns(const int * src, int * dst, long start, long middle, long end) {
+  long n1 = start;
+  long n2 = middle;
+  long out = start;
+  while (n1 < middle && n2 < end) {
+    if (src[n2] < src[n1]) dst[out++] = src[n2++];
+    else dst[out++] = src[n1++];
+  }
+  while (n1 < middle) dst[out++] = src[n1++];
+  while (n2 < end) dst[out++] = src[n2++];
+}
+
+/*
+ * Function: parallelSort
+ * Usage: parallelSort(vec, threads);
+ * ----------------------------------
+ * Sorts the vector with threads threads:
+ *
+ * 1. Every thread sorts a chunk of n / threads elements (rounded up)
+ *    with bottomUpSort.
+ * 2. The chunks are merged in pairs into runs of twice their width,
+ *    back and forth between vec and a scratch buffer, until one run
+ *    covers the whole vector. The output of every level is cut into
+ *    threads equal parts and each thread merges one part, so even the
+ *    last merge of two halves keeps all threads busy.
+ */
+void parallelSort(vector<int> & vec, int threads) {
+  long n = vec.size();
+  if (threads == 1 || n <= (long) threads * RUN_SIZE) {
+    bottomUpSort(vec);
+    return;
+  }
+  vector<int> scratch(n);
+  ParallelMerge state;
+  state.src = &vec[0];
+  state.dst = &scratch[0];
+  state.n = n;
+  state.chunk = (n + threads - 1) / threads;
+  state.threads = threads;
+  vector<thread> workers;
+  for (int i = 1; i < threads; i++) workers.push_back(thread(chunkWorker, ref(state), i));
+  chunkWorker(state, 0);
+  for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+  for (state.width = state.chunk; state.width < n; state.width *= 2) {
+    workers.clear();
+    for (int i = 1; i < threads; i++) workers.push_back(thread(mergeWorker, ref(state), i));
+    mergeWorker(state, 0);
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    swap(state.src, state.dst);
+  }
+  if (state.src != &vec[0]) vec.swap(scratch);
+}
+
+/*
+ * Function: chunkWorker
+ * Usage: thread(chunkWorker, ref(state), id);
+ * -------------------------------------------
+ * Sorts chunk id of state.src in place, using the same part of state.dst
+ * as scratch.
+ */
+void chunkWorker(ParallelMerge & state, int id) {
+  long start = min(id * state.chunk, state.n);
+  long size = min(state.chunk, state.n - start);
+  int * data = state.src + start;
+  int * result = bottomUpSort(data, state.dst + start, size);
+  if (result != data) copy(result, result + size, data);
+}
+
+/*
+ * Function: mergeWorker
+ * Usage: thread(mergeWorker, ref(state), id);
+ * -------------------------------------------
+ * Writes the output slots of thread id for the current merge level. The
+ * slots may cover the end of one pair of runs and the start of the next
+ * ones; for every pair they touch, coRank finds how many elements of
+ * each run come before the first and after the last slot (the merge
+ * path), and the elements in between are merged with mergeRuns.
+ */
+void mergeWorker(ParallelMerge & state, int id) {
+  long n = state.n, width = state.width;
+  long out_begin = id * n / state.threads;
+  long out_end = (id + 1) * n / state.threads;
+  for (long start = out_begin - out_begin % (2 * width); start < out_end; start += 2 * width) {
+    long middle = min(start + width, n);
+    long end = min(start + 2 * width, n);
+    const int * a = state.src + start;
+    const int * b = state.src + middle;
+    long size_a = middle - start, size_b = end - middle;
+    long first = max(out_begin, start) - start;
+    long last = min(out_end, end) - start;
+    long i0 = coRank(first, a, size_a, b, size_b);
+    long i1 = coRank(last, a, size_a, b, size_b);
+    long j0 = first - i0, j1 = last - i1;
+    // merge a[i0 .. i1 - 1] and b[j0 .. j1 - 1] into dst[start + first ..]
+    int * dst = state.dst + start + first;
+    while (i0 < i1 && j0 < j1) {
+      if (b[j0] < a[i0]) *dst++ = b[j0++];
+      else *dst++ = a[i0++];
+    }
+    while (i0 < i1) *dst++ = a[i0++];
+    while (j0 < j1) *dst++ = b[j0++];
+  }
+}
+
+/*
+ * Function: coRank
+ * ----------------
+ * Returns how many elements of the sorted array a are among the first k
+ * elements of the merge of a and b, where ties are taken from a first
+ * like mergeRuns does. The other k - i elements come from b. Found by
+ * binary search for the smallest i with b[k - i - 1] < a[i].
+ */
+long coRank(long k, const int * a, long size_a, const int * b, long size_b) {
+  long lo = max(0L, k - size_b);
+  long hi = min(k, size_a);
+  while (lo < hi) {
+    long i = lo + (hi - lo) / 2;
+    if (a[i] <= b[k - i - 1]) lo = i + 1;
+    else hi = i;
+  }
+  return lo;
+}
+
+/*
+ * Function: scalingBenchmark
+ * Usage: scalingBenchmark(numbers, max_threads);
+ * ----------------------------------------------
+ * Sorts copies of numbers with bottomUpSort and with parallelSort on 1,
+ * 2, 4, ... max_threads threads and prints the time of each run, its
+ * speedup over bottomUpSort and whether its result differs.
+ */
+void scalingBenchmark(vector<int> & numbers, int max_threads) {
+  typedef chrono::steady_clock Clock;
+  cout << "numbers: " << numbers.size() << endl;
+  vector<int> expected(numbers);
+  Clock::time_point start = Clock::now();
+  bottomUpSort(expected);
+  double serial_time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "bottomup: " << serial_time << " s" << endl;
+  for (int threads = 1; ; threads = min(threads * 2, max_threads)) {
+    vector<int> vec(numbers);
+    start = Clock::now();
+    parallelSort(vec, threads);
+    double time = chrono::duration<double>(Clock::now() - start).count();
+    cout << threads << " threads: " << time << " s, speedup " << serial_time / time
+	 << (vec == expected ? "" : " MISMATCH") << endl;
+    if (threads == max_threads) break;
+  }
+}
+
+/*
+ * Function: benchmark
+ * Usage: benchmark(numbers);
+ * --------------------------
+ * Sorts copies of numbers with sort and with bottomUpSort and prints the
+ * time, the heap allocations and the allocated bytes of each, and
+ * whether the results differ.
+ */
+void benchmark(vector<int> & numbers) {
+  typedef chrono::steady_clock Clock;
+  cout << "numbers: " << numbers.size() << endl;
+  vector<int> expected(numbers);
+  long before = allocations, bytes_before = allocated_bytes;
+  Clock::time_point start = Clock::now();
+  sort(expected);
+  double recursive_time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "recursive: " << recursive_time << " s, " << allocations - before
+       << " allocations, " << allocated_bytes - bytes_before << " bytes" << endl;
+
+  vector<int> vec(numbers);
+  before = allocations;
+  bytes_before = allocated_bytes;
+  start = Clock::now();
+  bottomUpSort(vec);
+  double time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "bottomup:  " << time << " s, " << allocations - before
+       << " allocations, " << allocated_bytes - bytes_before << " bytes, speedup "
+       << recursive_time / time << (vec == expected ? "" : " MISMATCH") << endl;
+}
+
+/*
+ * Function: radixBenchmark
+ * Usage: radixBenchmark(numbers);
+ * -------------------------------
+ * Sorts copies of numbers with sort, bottomUpSort and radixSort and
+ * prints the time of each and whether the results differ.
+ */
+void radixBenchmark(vector<int> & numbers) {
+  typedef chrono::steady_clock Clock;
+  cout << "numbers: " << numbers.size() << endl;
+  vector<int> expected(numbers);
+  Clock::time_point start = Clock::now();
+  sort(expected);
+  double recursive_time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "recursive: " << recursive_time << " s" << endl;
+
+  vector<int> vec(numbers);
+  start = Clock::now();
+  bottomUpSort(vec);
+  double time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "bottomup:  " << time << " s, speedup " << recursive_time / time
+       << (vec == expected ? "" : " MISMATCH") << endl;
+
+  vec = numbers;
+  start = Clock::now();
+  radixSort(vec);
+  time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "radix:     " << time << " s, speedup " << recursive_time / time
+       << (vec == expected ? "" : " MISMATCH") << endl;
+}
+
+/*
+ * Function: randomNumbers
+ * -----------------------
+ * Fills vec with size random numbers from a fixed seed.
+ */
+void randomNumbers(vector<int> & vec, int size) {
+  mt19937 generator(size);
+  vec.resize(size);
+  for (int i = 0; i < size; i++) vec[i] = generator();
+}
+
+/*
+ * Function: externalSort
+ * Usage: externalSort(in, out, memory);
+ * -------------------------------------
+ * Sorts the numbers of the text file in into the text file out, one
+ * number per line, using about memory bytes:
+ *
+ * 1. makeRuns cuts the input into runs of memory / 8 longs, sorts each
+ *    in memory and writes it in binary to a temporary file.
+ * 2. While there are more than MAX_FAN_IN runs, groups of MAX_FAN_IN
+ *    runs are merged into one longer run each.
+ * 3. The last runs are merged straight into out.
+ *
+ * Numbers too large for a long are skipped with a warning. Returns false
+ * if a file could not be written; the open runs are closed in every case.
+ */
+bool externalSort(FILE * in, FILE * out, long memory) {
+  IoBuffer input = {in, vector<char>(min(memory / 16, 64L << 20)), 0, 0};
+  vector<FILE *> runs;
+  long skipped = 0;
+  makeRuns(input, memory / sizeof(long), runs, skipped);
+  input.data = vector<char>();
+  if (skipped > 0) cerr << "Warning: skipped " << skipped << " numbers too large for a long" << endl;
+  if (runs.empty()) return true; // empty input
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (runs[i] == NULL) {
+      closeRuns(runs, 0);
+      return false;
+    }
+  }
+  while (runs.size() > (size_t) MAX_FAN_IN) {
+    vector<FILE *> merged;
+    for (size_t first = 0; first < runs.size(); first += MAX_FAN_IN) {
+      int last = min(first + MAX_FAN_IN, runs.size()) - 1;
+      FILE * run = tempFile();
+      if (run == NULL || mergeRunFiles(runs, first, last, memory, run, false) == NULL) {
+	if (run == NULL) closeRuns(runs, first); // mergeRunFiles closes its own runs
+	else {
+	  fclose(run);
+	  closeRuns(runs, last + 1);
+	}
+	closeRuns(merged, 0);
+	return false;
+      }
+      rewind(run);
+      merged.push_back(run);
+    }
+    runs.swap(merged);
+  }
+  return mergeRunFiles(runs, 0, runs.size() - 1, memory, out, true) != NULL;
+}
+
+/*
+ * Function: makeRuns
+ * ------------------
+ * Reads the input run_size numbers at a time, sorts them and appends a
+ * temporary file with the sorted run, rewound for reading, to runs. A
+ * NULL entry means a run could not be written.
+ */
+void makeRuns(IoBuffer & input, long run_size, vector<FILE *> & runs, long & skipped) {
+  vector<long> run;
+  run.reserve(run_size);
+  long value;
+  bool more = true;
+  while (more) {
+    run.clear();
+    while ((long) run.size() < run_size && (more = readNumber(input, value, skipped))) run.push_back(value);
+    if (run.empty()) break;
+    std::sort(run.begin(), run.end());
+    FILE * file = tempFile();
+    if (file != NULL && (fwrite(&run[0], sizeof(long), run.size(), file) != run.size()
+			 || fflush(file) != 0)) {
+      fclose(file);
+      file = NULL;
+    }
+    if (file != NULL) rewind(file);
+    runs.push_back(file);
+  }
+}
+
+/*
+ * Function: tempFile
+ * ------------------
+ * Creates a temporary file in $TMPDIR, or /tmp if it is not set, opened
+ * for reading and writing. The file is unlinked at once, so the system
+ * deletes it when it is closed or the program ends. Returns NULL if the
+ * file cannot be created.
+ */
+FILE * tempFile() {
+  const char * dir = getenv("TMPDIR");
+  string path = string(dir != NULL && dir[0] != '\0' ? dir : "/tmp") + "/MergeSortXXXXXX";
+  vector<char> name(path.begin(), path.end());
+  name.push_back('\0');
+  int fd = mkstemp(&name[0]);
+  if (fd < 0) return NULL;
+  unlink(&name[0]);
+  FILE * file = fdopen(fd, "w+b");
+  if (file == NULL) close(fd);
+  return file;
+}
+
+/*
+ * Function: closeRuns
+ * -------------------
+ * Closes the runs from runs[first] to the end, skipping NULL entries.
+ */
+void closeRuns(vector<FILE *> & runs, size_t first) {
+  for (size_t i = first; i < runs.size(); i++) {
+    if (runs[i] != NULL) fclose(runs[i]);
+  }
+}
+
+/*
+ * Function: mergeRunFiles
+ * -----------------------
+ * Merges the binary runs runs[first] to runs[last] into out, as text if
+ * text is set and in binary otherwise, and closes the runs. Every run
+ * and out get an equal share of memory as buffer. The loser tree finds
+ * the smallest head among k runs with log2(k) comparisons. Returns out,
+ * or NULL if out could not be written.
+ */
+FILE * mergeRunFiles(vector<FILE *> & runs, int first, int last, long memory, FILE * out, bool text) {
+  int k = last - first + 1;
+  size_t buffer_size = max((size_t) memory / (k + 1), MIN_IO_BUFFER);
+  vector<IoBuffer> inputs(k);
+  LoserTree lt;
+  lt.k = k;
+  lt.heads.resize(k);
+  lt.done.resize(k);
+  for (int i = 0; i < k; i++) {
+    inputs[i].file = runs[first + i];
+    inputs[i].data.resize(buffer_size);
+    inputs[i].pos = inputs[i].size = 0;
+    lt.done[i] = !readLong(inputs[i], lt.heads[i]);
+  }
+  IoBuffer output = {out, vector<char>(buffer_size), 0, 0};
+  bool ok = true;
+  if (k > 0) {
+    buildLoserTree(lt);
+    while (ok && !lt.done[lt.tree[0]]) {
+      int winner = lt.tree[0];
+      if (text) ok = writeNumber(output, lt.heads[winner]);
+      else ok = writeBytes(output, &lt.heads[winner], sizeof(long));
+      lt.done[winner] = !readLong(inputs[winner], lt.heads[winner]);
+      replayLoserTree(lt, winner);
+    }
+  }
+  ok = flushBuffer(output) && ok;
+  for (int i = 0; i < k; i++) fclose(inputs[i].file);
+  return ok ? out : NULL;
+}
+
+/*
+ * Function: buildLoserTree
+ * ------------------------
+ * Plays the first matches of the tree: every leaf climbs until it finds
+ * an empty node, where it waits for the winner of the other subtree.
+ */
+void buildLoserTree(LoserTree & lt) {
+  lt.tree.assign(max(lt.k, 1), -1);
+  for (int i = 0; i < lt.k; i++) replayLoserTree(lt, i);
+}
+
+/*
+ * Function: replayLoserTree
+ * -------------------------
+ * Replays the matches from the leaf of run leaf up to the root after its
+ * head changed. At every node the loser stays and the winner climbs on.
+ */
+void replayLoserTree(LoserTree & lt, int leaf) {
+  int winner = leaf;
+  for (int node = (leaf + lt.k) / 2; node > 0; node /= 2) {
+    if (lt.tree[node] == -1) {
+      lt.tree[node] = winner;
+      return;
+    }
+    if (beats(lt, lt.tree[node], winner)) swap(lt.tree[node], winner);
+  }
+  lt.tree[0] = winner;
+}
+
+/*
+ * Function: beats
+ * ---------------
+ * Returns true if run a wins its match against run b: it still has a
+ * head and that head is smaller, or equal with a smaller run number.
+ */
+bool beats(LoserTree & lt, int a, int b) {
+  if (lt.done[a] || lt.done[b]) return !lt.done[a];
+  return lt.heads[a] < lt.heads[b] || (lt.heads[a] == lt.heads[b] && a < b);
+}
+
+/*
+ * Function: readNumber
+ * --------------------
+ * Reads the next decimal integer from a text input, skipping anything
+ * that is not a digit; a minus sign right before the digits makes the
+ * number negative. Numbers too large for a long are skipped and counted
+ * in skipped. Returns false at the end of the input.
+ */
+bool readNumber(IoBuffer & input, long & value, long & skipped) {
+  bool negative = false; // the previous character was a minus sign
+  while (true) {
+    if (input.pos == input.size) {
+      input.size = fread(&input.data[0], 1, input.data.size(), input.file);
+      input.pos = 0;
+      if (input.size == 0) return false;
+    }
+    char c = input.data[input.pos];
+    if (c < '0' || c > '9') {
+      negative = c == '-';
+      input.pos++;
+      continue;
+    }
+    unsigned long limit = negative ? (unsigned long) LONG_MAX + 1 : LONG_MAX;
+    unsigned long result = 0;
+    bool overflow = false;
+    while (true) {
+      if (input.pos == input.size) {
+	input.size = fread(&input.data[0], 1, input.data.size(), input.file);
+	input.pos = 0;
+	if (input.size == 0) break;
+      }
+      c = input.data[input.pos];
+      if (c < '0' || c > '9') break;
+      unsigned long digit = c - '0';
+      if (result > (limit - digit) / 10) overflow = true;
+      else result = result * 10 + digit;
+      input.pos++;
+    }
+    if (!overflow) {
+      value = negative ? (long) (0 - result) : (long) result;
+      return true;
+    }
+    skipped++;
+    negative = false;
+  }
+}
+
+/*
+ * Function: readLong
+ * ------------------
+ * Reads the next long from a binary run. Returns false at its end.
+ */
+bool readLong(IoBuffer & input, long & value) {
+  if (input.pos + sizeof(long) > input.size) {
+    input.size = fread(&input.data[0], sizeof(long), input.data.size() / sizeof(long),
+		       input.file) * sizeof(long);
+    input.pos = 0;
+    if (input.size == 0) return false;
+  }
+  memcpy(&value, &input.data[input.pos], sizeof(long));
+  input.pos += sizeof(long);
+  return true;
+}
+
+/*
+ * Function: writeBytes
+ * --------------------
+ * Appends bytes to an output buffer, flushing the buffer first if they
+ * do not fit. Returns false if the flush failed.
+ */
+bool writeBytes(IoBuffer & output, const void * bytes, size_t size) {
+  if (output.pos + size > output.data.size() && !flushBuffer(output)) return false;
+  memcpy(&output.data[output.pos], bytes, size);
+  output.pos += size;
+  return true;
+}
+
+/*
+ * Function: writeNumber
+ * ---------------------
+ * Appends a number and a newline to an output buffer, flushing the
+ * buffer first if the number might not fit. Returns false if the flush
+ * failed.
+ */
+bool writeNumber(IoBuffer & output, long value) {
+  if (output.pos + 24 > output.data.size() && !flushBuffer(output)) return false;
+  char digits[24];
+  int n = 0;
+  unsigned long magnitude = value < 0 ? 0UL - value : value;
+  do {
+    digits[n++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0);
+  if (value < 0) output.data[output.pos++] = '-';
+  while (n > 0) output.data[output.pos++] = digits[--n];
+  output.data[output.pos++] = '\n';
+  return true;
+}
+
+/*
+ * Function: flushBuffer
+ * ---------------------
+ * Writes what is waiting in an output buffer to its file. Returns false
+ * if the file could not be written.
+ */
+bool flushBuffer(IoBuffer & output) {
+  bool ok = output.pos == 0 || fwrite(&output.data[0], 1, output.pos, output.file) == output.pos;
+  output.pos = 0;
+  return ok;
+}
+
 /*
  * Function: readFile
  * Usage: vector<int> vec; readFile(vec);
@@ -149,3 +938,14 @@ bool testFileName(ifstream & infile, string filename) {
   infile.open(filename.c_str());
   return !infile.fail();
 }
+
+int stringToInteger(string str) {
+  istringstream stream(str);
+  int value;
+  stream >> value;
+  if (stream.fail() || !(stream >> ws).eof()) {
+    cerr << "stringToInteger: Illegal integer format (" + str + ")";
+    return 1;
+  }
+  return value;
+}
@@ -5,14 +5,97 @@
  * algorithm to sort a list of integers. It reads integers from a file
  * specified as the first argument of the program or prompted for
  * and writes the result to std output.
+ *
+ * An optional MODE argument after the file name selects the sort:
+ *   count - the course version: plain recursive quick sort with a median
+ *           of three pivot that also prints the number of comparisons
+ *           (default, see qs_answers.txt)
+ *   sort  - the production version: insertion sort below INSERTION_CUTOFF
+ *           elements, 3-way partitioning so runs of equal keys are not
+ *           recursed into, a fall back to heap sort when the recursion
+ *           gets deeper than 2 log2(n), and a loop instead of recursion
+ *           for the larger part, which bounds the stack to O(log n)
+ *   parallel [THREADS]
+ *         - the production version on THREADS threads (default: one per
+ *           core). Ranges above PARALLEL_CUTOFF elements are partitioned
+ *           and one part is handed to a work-stealing pool, the rest is
+ *           sorted like the sort mode
+ *   bench [MAX_THREADS [MAX_SIZE]]
+ *         - times the sort mode and the parallel mode with 1, 2, 4, ...
+ *           MAX_THREADS threads on the numbers of the file, then on
+ *           random longs with 10^6, 10^7, ... MAX_SIZE elements
+ *   block - the production version with blockPartition, a branchless
+ *           2-way partition (BlockQuicksort), in place of partition3
+ *   partbench [SIZE]
+ *         - partitions random longs with partition and blockPartition
+ *           and prints the cycles per element of each (default size:
+ *           the number of numbers in the file)
+ *   select K...
+ *         - prints the K-th smallest number for every K, without sorting
+ *   percentile P...
+ *         - prints the P-th percentile (nearest rank) for every P
+ *   selectbench [SIZE]
+ *         - times select and percentile queries against the sort mode
+ *           followed by indexing, on the numbers of the file or on SIZE
+ *           random longs
+ *   radix - LSD radix sort, see ../radix/RadixSort.h
+ *   radixbench [SIZE]
+ *         - times the sort, block and radix modes on the numbers of the
+ *           file or on SIZE random longs
  */
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <vector>
+#include <deque>
+#include <sstream>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include "../radix/RadixSort.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 using namespace std;
 
+const int INSERTION_CUTOFF = 16; // ranges this small are insertion sorted
+const int PARALLEL_CUTOFF = 1 << 14; // ranges this small are not split into tasks
+const int BLOCK_SIZE = 128; // elements blockPartition scans before it swaps
+
+/*
+ * Type: SortTask
+ * --------------
+ * A range of the vector to sort, indexes start to end inclusive, with
+ * the depth limit left for it.
+ */
+struct SortTask {
+  int start;
+  int end;
+  int depth_limit;
+};
+
+/*
+ * Type: TaskPool
+ * --------------
+ * The state shared by the threads of the parallel sort. Every thread
+ * owns one deque of tasks: it adds and takes its own tasks at the back
+ * and, when its deque is empty, steals from the front of the others,
+ * where the oldest and largest tasks are. pending counts the tasks that
+ * were added but not finished; the sort is done when it drops to zero.
+ */
+struct TaskPool {
+  vector<long> * vec;
+  int threads;
+  vector<deque<SortTask> > queues;
+  vector<mutex> * locks; // one per deque
+  atomic<long> pending;
+};
+
 /* Function prototypes */
 
 string promptUserForFile(ifstream & infile, string prompt);
@@ -25,6 +108,36 @@ void readFile(vector<long> & vec, ifstream & infile);
 void print(vector<long> & vec);
 void print_h(vector<long> & vec);
 
+void introSort(vector<long> & vec, int start, int end);
+void introSort(vector<long> & vec, int start, int end, int depth_limit);
+void partition3(vector<long> & vec, int l, int r, int & lt, int & gt);
+void partition3(vector<long> & vec, int l, int r, long p_value, int & lt, int & gt);
+void insertionSort(vector<long> & vec, int start, int end);
+void heapSort(vector<long> & vec, int start, int end);
+void siftDown(vector<long> & vec, int start, int node, int size);
+void blockSort(vector<long> & vec, int start, int end);
+void blockSort(vector<long> & vec, int start, int end, int depth_limit);
+int blockPartition(vector<long> & vec, int l, int r);
+void partitionBenchmark(vector<long> & numbers);
+unsigned long long cycleCount();
+long quickSelect(vector<long> & vec, int start, int end, int k, mt19937 & rng);
+void quickSelect(vector<long> & vec, int start, int end, int k, int depth_limit, mt19937 & rng);
+void multiSelect(vector<long> & vec, int start, int end, vector<int> & ks,
+		 int first, int last, mt19937 & rng);
+long medianOfMedians(vector<long> & vec, int start, int end, mt19937 & rng);
+int percentileRank(double percentile, int n);
+void selectBenchmark(vector<long> & numbers);
+void radixBenchmark(vector<long> & numbers);
+void parallelSort(vector<long> & vec, int threads);
+void sortWorker(TaskPool & pool, int id);
+bool takeTask(TaskPool & pool, int id, SortTask & task);
+void runTask(TaskPool & pool, int id, SortTask task);
+void benchmark(vector<long> & numbers, int max_threads);
+void randomNumbers(vector<long> & vec, long size);
+int stringToInteger(string str);
+long stringToLong(string str);
+double stringToReal(string str);
+
 /* Main program */
 
 using namespace std;
@@ -32,6 +145,19 @@ using namespace std;
 int main(int argc, char* argv[]) {
   vector<long> in_numbers;
   ifstream infile;
+  string mode = argc > 2 ? argv[2] : "count";
+  if (mode != "count" && mode != "sort" && mode != "parallel" && mode != "bench" &&
+      mode != "block" && mode != "partbench" && mode != "select" && mode != "percentile" &&
+      mode != "selectbench" && mode != "radix" && mode != "radixbench") {
+    cerr << "Unknown mode: " << mode << "\n"
+	 << "Usage: " << argv[0] << " FILENAME [count|sort|block|radix]\n"
+	 << "       " << argv[0] << " FILENAME partbench|selectbench|radixbench [SIZE]\n"
+	 << "       " << argv[0] << " FILENAME select K...\n"
+	 << "       " << argv[0] << " FILENAME percentile P...\n"
+	 << "       " << argv[0] << " FILENAME parallel [THREADS]\n"
+	 << "       " << argv[0] << " FILENAME bench [MAX_THREADS [MAX_SIZE]]" << endl;
+    return 1;
+  }
   if (argc < 2) {
     promptUserForFile(infile, "Input file: ");
   }
@@ -43,6 +169,70 @@ int main(int argc, char* argv[]) {
     }
   }
   readFile(in_numbers, infile);
+  if (mode == "sort") {
+    introSort(in_numbers, 0, in_numbers.size() - 1);
+    print(in_numbers);
+    return 0;
+  }
+  if (mode == "block") {
+    blockSort(in_numbers, 0, in_numbers.size() - 1);
+    print(in_numbers);
+    return 0;
+  }
+  if (mode == "radix") {
+    radixSort(in_numbers);
+    print(in_numbers);
+    return 0;
+  }
+  if (mode == "radixbench") {
+    if (argc > 3) randomNumbers(in_numbers, stringToLong(argv[3]));
+    radixBenchmark(in_numbers);
+    return 0;
+  }
+  if (mode == "partbench") {
+    if (argc > 3) randomNumbers(in_numbers, stringToLong(argv[3]));
+    partitionBenchmark(in_numbers);
+    return 0;
+  }
+  if (mode == "select" || mode == "percentile") {
+    int n = in_numbers.size();
+    vector<int> ks;
+    for (int i = 3; i < argc; i++) {
+      int k = mode == "select" ? stringToInteger(argv[i]) : percentileRank(stringToReal(argv[i]), n);
+      if (k < 1 || k > n) {
+	cerr << argv[i] << " is out of range for " << n << " numbers" << endl;
+	return 1;
+      }
+      ks.push_back(k - 1);
+    }
+    vector<int> sorted_ks(ks);
+    sort(sorted_ks.begin(), sorted_ks.end());
+    mt19937 rng(n);
+    multiSelect(in_numbers, 0, n - 1, sorted_ks, 0, sorted_ks.size() - 1, rng);
+    for (int i = 3; i < argc; i++) cout << argv[i] << ": " << in_numbers[ks[i - 3]] << endl;
+    return 0;
+  }
+  if (mode == "selectbench") {
+    if (argc > 3) randomNumbers(in_numbers, stringToLong(argv[3]));
+    selectBenchmark(in_numbers);
+    return 0;
+  }
+  int threads = argc > 3 ? stringToInteger(argv[3]) : thread::hardware_concurrency();
+  threads = max(threads, 1);
+  if (mode == "parallel") {
+    parallelSort(in_numbers, threads);
+    print(in_numbers);
+    return 0;
+  }
+  if (mode == "bench") {
+    long max_size = argc > 4 ? stringToLong(argv[4]) : 0;
+    benchmark(in_numbers, threads);
+    for (long size = 1000000; size <= max_size; size *= 10) {
+      randomNumbers(in_numbers, size);
+      benchmark(in_numbers, threads);
+    }
+    return 0;
+  }
   unsigned long count;
   count = quickSort(in_numbers, 0, in_numbers.size() - 1);
   print(in_numbers);
@@ -109,7 +299,7 @@ int partition(vector<long> & vec, int l, int r) {
   // cout << "part: " << l << ", " << r << endl;  
   int p = choosePivot(vec, l, r);
   // cout << "p: " << p << endl;
-  int p_value = vec[p];
+  long p_value = vec[p];
   int i = l + 1;
   for (int j = l + 1; j < r + 1; j++) {
     if (vec[j] < p_value) { // if vec[j] > p do nothing
@@ -131,11 +321,614 @@ int partition(vector<long> & vec, int l, int r) {
 void swap(vector<long> & vec, int i, int j) {
   // print_h(vec);
   // cout << "swap: " << i << ", " << j << endl;
-  int tmp = vec[i];
+  long tmp = vec[i];
   vec[i] = vec[j];
   vec[j] = tmp;
 }
 
+/*
+ * Function: introSort
+ * Usage: introSort(vec, 0, vec.size() - 1);
+ * -----------------------------------------
+ * Sorts the elements of vec between indexes start and end inclusive:
+ *
+ * (1) While the range has more than INSERTION_CUTOFF elements:
+ *     (a) if the depth limit is used up, heap sort the range and return
+ *     (b) 3-way partition the range around a median of three pivot
+ *     (c) recurse on the smaller of the parts less than and greater
+ *         than the pivot, and continue the loop with the larger one
+ * (2) Insertion sort what is left.
+ */
+void introSort(vector<long> & vec, int start, int end) {
+  int depth_limit = 0;
+  for (int n = end - start + 1; n > 1; n /= 2) depth_limit += 2;
+  introSort(vec, start, end, depth_limit);
+}
+
+void introSort(vector<long> & vec, int start, int end, int depth_limit) {
+  while (end - start + 1 > INSERTION_CUTOFF) {
+    if (depth_limit == 0) {
+      heapSort(vec, start, end);
+      return;
+    }
+    depth_limit--;
+    int lt, gt;
+    partition3(vec, start, end, lt, gt);
+    if (lt - start < end - gt) {
+      introSort(vec, start, lt - 1, depth_limit);
+      start = gt + 1;
+    } else {
+      introSort(vec, gt + 1, end, depth_limit);
+      end = lt - 1;
+    }
+  }
+  insertionSort(vec, start, end);
+}
+
+/*
+ * Function: partition3
+ * --------------------
+ * Partitions the vector between l and r around the pivot picked by
+ * choosePivot, or around p_value, into three parts (Dutch national
+ * flag): the elements less than the pivot end up at indexes l to lt - 1,
+ * the elements equal to it at lt to gt and the elements greater than it
+ * at gt + 1 to r.
+ */
+void partition3(vector<long> & vec, int l, int r, int & lt, int & gt) {
+  partition3(vec, l, r, vec[choosePivot(vec, l, r)], lt, gt);
+}
+
+void partition3(vector<long> & vec, int l, int r, long p_value, int & lt, int & gt) {
+  lt = l;
+  gt = r;
+  int i = l;
+  while (i <= gt) {
+    if (vec[i] < p_value) swap(vec, lt++, i++);
+    else if (vec[i] > p_value) swap(vec, i, gt--);
+    else i++;
+  }
+}
+
+/*
+ * Function: insertionSort
+ * -----------------------
+ * Sorts the elements between start and end inclusive by inserting each
+ * element into the sorted part before it.
+ */
+void insertionSort(vector<long> & vec, int start, int end) {
+  for (int i = start + 1; i <= end; i++) {
+    long value = vec[i];
+    int j = i - 1;
+    while (j >= start && vec[j] > value) {
+      vec[j + 1] = vec[j];
+      j--;
+    }
+    vec[j + 1] = value;
+  }
+}
+
+/*
+ * Function: heapSort
+ * ------------------
+ * Sorts the elements between start and end inclusive with heap sort:
+ * turn the range into a max-heap, then repeatedly swap the maximum to
+ * the end of the heap and shrink the heap by one.
+ */
+void heapSort(vector<long> & vec, int start, int end) {
+  int size = end - start + 1;
+  for (int node = size / 2 - 1; node >= 0; node--) siftDown(vec, start, node, size);
+  for (int last = size - 1; last > 0; last--) {
+    swap(vec, start, start + last);
+    siftDown(vec, start, 0, last);
+  }
+}
+
+/*
+ * Function: siftDown
+ * ------------------
+ * Moves the element at heap index node down the max-heap of size
+ * elements stored from index start on until both children are smaller.
+ */
+void siftDown(vector<long> & vec, int start, int node, int size) {
+  long value = vec[start + node];
+  while (2 * node + 1 < size) {
+    int child = 2 * node + 1;
+    if (child + 1 < size && vec[start + child + 1] > vec[start + child]) child++;
+    if (vec[start + child] <= value) break;
+    vec[start + node] = vec[start + child];
+    node = child;
+  }
+  vec[start + node] = value;
+}
+
+/*
+ * Function: blockSort
+ * Usage: blockSort(vec, 0, vec.size() - 1);
+ * -----------------------------------------
+ * Sorts the elements of vec between indexes start and end inclusive like
+ * introSort, but splits the ranges in two with blockPartition.
+ */
+void blockSort(vector<long> & vec, int start, int end) {
+  int depth_limit = 0;
+  for (int n = end - start + 1; n > 1; n /= 2) depth_limit += 2;
+  blockSort(vec, start, end, depth_limit);
+}
+
+void blockSort(vector<long> & vec, int start, int end, int depth_limit) {
+  while (end - start + 1 > INSERTION_CUTOFF) {
+    if (depth_limit == 0) {
+      heapSort(vec, start, end);
+      return;
+    }
+    depth_limit--;
+    int pivot = blockPartition(vec, start, end);
+    if (pivot - start < end - pivot) {
+      blockSort(vec, start, pivot - 1, depth_limit);
+      start = pivot + 1;
+    } else {
+      blockSort(vec, pivot + 1, end, depth_limit);
+      end = pivot - 1;
+    }
+  }
+  insertionSort(vec, start, end);
+}
+
+/*
+ * Function: blockPartition
+ * ------------------------
+ * Partitions the vector between l and r around the pivot picked by
+ * choosePivot and returns the index of the pivot, like partition, but
+ * elements equal to the pivot may end up on either side of it.
+ *
+ * The comparisons of partition are branches the processor mispredicts
+ * half of the time on random keys. Here the unpartitioned range is
+ * scanned a block of BLOCK_SIZE elements at a time from both ends. The
+ * scan writes the offset of every element into a buffer and advances
+ * the buffer end by the result of the comparison, so it records the
+ * elements on the wrong side without a branch. Then the recorded
+ * elements of both buffers are swapped in pairs, and a block is done
+ * once its buffer is used up. The last two blocks or less are
+ * partitioned with an ordinary Hoare scan.
+ */
+int blockPartition(vector<long> & vec, int l, int r) {
+  long p_value = vec[choosePivot(vec, l, r)];
+  long * a = &vec[0];
+  int offsets_l[BLOCK_SIZE], offsets_r[BLOCK_SIZE];
+  int num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+  int i = l + 1, j = r; // a[l + 1 .. i - 1] <= p_value <= a[j + 1 .. r]
+  while (j - i + 1 > 2 * BLOCK_SIZE) {
+    if (num_l == 0) {
+      start_l = 0;
+      for (int k = 0; k < BLOCK_SIZE; k++) {
+	offsets_l[num_l] = k;
+	num_l += a[i + k] >= p_value;
+      }
+    }
+    if (num_r == 0) {
+      start_r = 0;
+      for (int k = 0; k < BLOCK_SIZE; k++) {
+	offsets_r[num_r] = k;
+	num_r += a[j - k] <= p_value;
+      }
+    }
+    int num = min(num_l, num_r);
+    for (int k = 0; k < num; k++) {
+      long tmp = a[i + offsets_l[start_l + k]];
+      a[i + offsets_l[start_l + k]] = a[j - offsets_r[start_r + k]];
+      a[j - offsets_r[start_r + k]] = tmp;
+    }
+    num_l -= num;
+    num_r -= num;
+    start_l += num;
+    start_r += num;
+    if (num_l == 0) i += BLOCK_SIZE;
+    if (num_r == 0) j -= BLOCK_SIZE;
+  }
+  while (true) {
+    while (i <= j && a[i] < p_value) i++;
+    while (i <= j && a[j] > p_value) j--;
+    if (i >= j) break;
+    swap(vec, i++, j--);
+  }
+  swap(vec, l, i - 1);
+  return i - 1;
+}
+
+/*
+ * Function: partitionBenchmark
+ * Usage: partitionBenchmark(numbers);
+ * -----------------------------------
+ * Partitions copies of numbers with partition and with blockPartition,
+ * repeating each until about 10^7 elements are done, and prints the
+ * processor cycles per element of each and the times of the sort and
+ * block modes on numbers.
+ */
+void partitionBenchmark(vector<long> & numbers) {
+  typedef chrono::steady_clock Clock;
+  int n = numbers.size();
+  cout << "numbers: " << n << endl;
+  if (n < 2) return;
+  int rounds = max(10000000 / n, 1);
+  unsigned long long lomuto_cycles = 0, block_cycles = 0;
+  bool valid = true;
+  for (int round = 0; round < rounds; round++) {
+    vector<long> vec(numbers);
+    unsigned long long start = cycleCount();
+    int p = partition(vec, 0, n - 1);
+    lomuto_cycles += cycleCount() - start;
+    vec = numbers;
+    start = cycleCount();
+    int q = blockPartition(vec, 0, n - 1);
+    block_cycles += cycleCount() - start;
+    if (round == 0) {
+      for (int k = 0; k < n; k++) {
+	if ((k < q && vec[k] > vec[q]) || (k > q && vec[k] < vec[q])) valid = false;
+      }
+      cout << "pivot index: " << p << " / " << q << endl;
+    }
+  }
+  double elements = (double) rounds * n;
+  cout << "partition:      " << lomuto_cycles / elements << " cycles/element" << endl;
+  cout << "blockPartition: " << block_cycles / elements << " cycles/element"
+       << (valid ? "" : " NOT PARTITIONED") << endl;
+
+  vector<long> expected(numbers);
+  Clock::time_point start = Clock::now();
+  introSort(expected, 0, n - 1);
+  double sort_time = chrono::duration<double>(Clock::now() - start).count();
+  vector<long> vec(numbers);
+  start = Clock::now();
+  blockSort(vec, 0, n - 1);
+  double block_time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "sort:  " << sort_time << " s" << endl;
+  cout << "block: " << block_time << " s" << (vec == expected ? "" : " MISMATCH") << endl;
+}
+
+/*
+ * Function: cycleCount
+ * --------------------
+ * Returns the time stamp counter of the processor, or nanoseconds on
+ * processors without one.
+ */
+unsigned long long cycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/*
+ * Function: quickSelect
+ * Usage: long median = quickSelect(vec, 0, vec.size() - 1, vec.size() / 2, rng);
+ * ------------------------------------------------------------------------------
+ * Returns the element with index k of vec between start and end if that
+ * part of vec was sorted, and rearranges vec so that it is at index k,
+ * with no greater element before it and no smaller one after it.
+ *
+ * Each round puts a random element in the middle of the range, takes the
+ * median of three of choosePivot as pivot, partitions the range in three
+ * with partition3 and goes on with the part that holds k. If the depth
+ * limit of 2 log2(n) rounds is used up, bad pivots keep coming and the
+ * pivots are taken with medianOfMedians instead, which bounds the rest
+ * of the search to linear time.
+ */
+long quickSelect(vector<long> & vec, int start, int end, int k, mt19937 & rng) {
+  int depth_limit = 0;
+  for (int n = end - start + 1; n > 1; n /= 2) depth_limit += 2;
+  quickSelect(vec, start, end, k, depth_limit, rng);
+  return vec[k];
+}
+
+void quickSelect(vector<long> & vec, int start, int end, int k, int depth_limit, mt19937 & rng) {
+  while (end - start + 1 > INSERTION_CUTOFF) {
+    long p_value;
+    if (depth_limit > 0) {
+      depth_limit--;
+      swap(vec, start + (end - start) / 2, start + rng() % (end - start + 1));
+      p_value = vec[choosePivot(vec, start, end)];
+    } else {
+      p_value = medianOfMedians(vec, start, end, rng);
+    }
+    int lt, gt;
+    partition3(vec, start, end, p_value, lt, gt);
+    if (k < lt) end = lt - 1;
+    else if (k > gt) start = gt + 1;
+    else return;
+  }
+  insertionSort(vec, start, end);
+}
+
+/*
+ * Function: multiSelect
+ * ---------------------
+ * Puts the elements with the indexes ks[first] to ks[last] in place like
+ * quickSelect. ks must be sorted. The middle index is selected first,
+ * which leaves the smaller indexes before it and the larger ones after
+ * it, so the two halves of ks are searched in disjoint ranges of vec.
+ */
+void multiSelect(vector<long> & vec, int start, int end, vector<int> & ks,
+		 int first, int last, mt19937 & rng) {
+  if (first > last) return;
+  int middle = first + (last - first) / 2;
+  int k = ks[middle];
+  quickSelect(vec, start, end, k, rng);
+  multiSelect(vec, start, k - 1, ks, first, middle - 1, rng);
+  multiSelect(vec, k + 1, end, ks, middle + 1, last, rng);
+}
+
+/*
+ * Function: medianOfMedians
+ * -------------------------
+ * Returns a pivot for the range between start and end that has at least
+ * 3/10 of the range on either side: the groups of five elements are
+ * insertion sorted, their medians moved to the front of the range, and
+ * the median of those found with quickSelect with no depth left, which
+ * calls this function again on the smaller range.
+ */
+long medianOfMedians(vector<long> & vec, int start, int end, mt19937 & rng) {
+  int medians = 0;
+  for (int group = start; group <= end; group += 5) {
+    int group_end = min(group + 4, end);
+    insertionSort(vec, group, group_end);
+    swap(vec, start + medians, group + (group_end - group) / 2);
+    medians++;
+  }
+  int k = start + (medians - 1) / 2;
+  quickSelect(vec, start, start + medians - 1, k, 0, rng);
+  return vec[k];
+}
+
+/*
+ * Function: percentileRank
+ * ------------------------
+ * Returns the nearest rank of a percentile of n numbers: the smallest
+ * rank with at least percentile percent of the numbers at or below it.
+ */
+int percentileRank(double percentile, int n) {
+  if (percentile < 0 || percentile > 100) return 0;
+  return max((int) ceil(percentile / 100 * n - 1e-9), 1);
+}
+
+/*
+ * Function: selectBenchmark
+ * Usage: selectBenchmark(numbers);
+ * --------------------------------
+ * Times quickSelect for the median, quickSelect with medianOfMedians
+ * pivots only, and multiSelect for a batch of percentiles against
+ * sorting a copy of numbers with introSort and indexing it, and checks
+ * that the answers agree.
+ */
+void selectBenchmark(vector<long> & numbers) {
+  typedef chrono::steady_clock Clock;
+  int n = numbers.size();
+  cout << "numbers: " << n << endl;
+  if (n == 0) return;
+  mt19937 rng(n);
+  vector<long> sorted(numbers);
+  Clock::time_point start = Clock::now();
+  introSort(sorted, 0, n - 1);
+  double sort_time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "sort:               " << sort_time << " s" << endl;
+
+  vector<long> vec(numbers);
+  start = Clock::now();
+  long median = quickSelect(vec, 0, n - 1, (n - 1) / 2, rng);
+  double time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "select median:      " << time << " s, speedup " << sort_time / time
+       << (median == sorted[(n - 1) / 2] ? "" : " MISMATCH") << endl;
+
+  vec = numbers;
+  start = Clock::now();
+  quickSelect(vec, 0, n - 1, (n - 1) / 2, 0, rng);
+  time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "median of medians:  " << time << " s, speedup " << sort_time / time
+       << (vec[(n - 1) / 2] == sorted[(n - 1) / 2] ? "" : " MISMATCH") << endl;
+
+  const double percentiles[] = {1, 5, 10, 25, 50, 75, 90, 95, 99, 99.9};
+  vector<int> ks;
+  for (size_t i = 0; i < sizeof percentiles / sizeof percentiles[0]; i++) {
+    ks.push_back(percentileRank(percentiles[i], n) - 1);
+  }
+  vec = numbers;
+  start = Clock::now();
+  multiSelect(vec, 0, n - 1, ks, 0, ks.size() - 1, rng);
+  time = chrono::duration<double>(Clock::now() - start).count();
+  bool agree = true;
+  for (size_t i = 0; i < ks.size(); i++) agree = agree && vec[ks[i]] == sorted[ks[i]];
+  cout << ks.size() << " percentiles:     " << time << " s, speedup " << sort_time / time
+       << (agree ? "" : " MISMATCH") << endl;
+}
+
+/*
+ * Function: radixBenchmark
+ * Usage: radixBenchmark(numbers);
+ * -------------------------------
+ * Sorts copies of numbers with introSort, blockSort and radixSort and
+ * prints the time of each and whether the results differ.
+ */
+void radixBenchmark(vector<long> & numbers) {
+  typedef chrono::steady_clock Clock;
+  int n = numbers.size();
+  cout << "numbers: " << n << endl;
+  vector<long> expected(numbers);
+  Clock::time_point start = Clock::now();
+  introSort(expected, 0, n - 1);
+  double sort_time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "sort:  " << sort_time << " s" << endl;
+
+  vector<long> vec(numbers);
+  start = Clock::now();
+  blockSort(vec, 0, n - 1);
+  double time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "block: " << time << " s, speedup " << sort_time / time
+       << (vec == expected ? "" : " MISMATCH") << endl;
+
+  vec = numbers;
+  start = Clock::now();
+  radixSort(vec);
+  time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "radix: " << time << " s, speedup " << sort_time / time
+       << (vec == expected ? "" : " MISMATCH") << endl;
+}
+
+/*
+ * Function: parallelSort
+ * Usage: parallelSort(vec, threads);
+ * ----------------------------------
+ * Sorts vec with threads threads. The whole vector is the first task of
+ * the calling thread, which works as thread 0 of the pool. A thread
+ * working on a task larger than PARALLEL_CUTOFF elements partitions it
+ * as introSort does, adds the smaller part to its deque as a new task
+ * and goes on with the larger part, so idle threads find work to steal
+ * right after the first partition.
+ */
+void parallelSort(vector<long> & vec, int threads) {
+  int n = vec.size();
+  if (threads == 1 || n <= PARALLEL_CUTOFF) {
+    introSort(vec, 0, n - 1);
+    return;
+  }
+  TaskPool pool;
+  vector<mutex> locks(threads);
+  pool.vec = &vec;
+  pool.threads = threads;
+  pool.queues.resize(threads);
+  pool.locks = &locks;
+  int depth_limit = 0;
+  for (int size = n; size > 1; size /= 2) depth_limit += 2;
+  SortTask task = {0, n - 1, depth_limit};
+  pool.queues[0].push_back(task);
+  pool.pending = 1;
+  vector<thread> workers;
+  for (int i = 1; i < threads; i++) workers.push_back(thread(sortWorker, ref(pool), i));
+  sortWorker(pool, 0);
+  for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+/*
+ * Function: sortWorker
+ * Usage: thread(sortWorker, ref(pool), id);
+ * -----------------------------------------
+ * Runs tasks of the pool on thread id until no task is pending anymore.
+ */
+void sortWorker(TaskPool & pool, int id) {
+  while (pool.pending > 0) {
+    SortTask task;
+    if (!takeTask(pool, id, task)) {
+      this_thread::yield();
+      continue;
+    }
+    runTask(pool, id, task);
+    pool.pending--;
+  }
+}
+
+/*
+ * Function: takeTask
+ * ------------------
+ * Takes the newest task of the deque of thread id or, if that is empty,
+ * steals the oldest task of the deque of another thread, starting with
+ * the next one. Returns false if all deques are empty.
+ */
+bool takeTask(TaskPool & pool, int id, SortTask & task) {
+  vector<mutex> & locks = *pool.locks;
+  {
+    lock_guard<mutex> guard(locks[id]);
+    if (!pool.queues[id].empty()) {
+      task = pool.queues[id].back();
+      pool.queues[id].pop_back();
+      return true;
+    }
+  }
+  for (int i = 1; i < pool.threads; i++) {
+    int victim = (id + i) % pool.threads;
+    lock_guard<mutex> guard(locks[victim]);
+    if (!pool.queues[victim].empty()) {
+      task = pool.queues[victim].front();
+      pool.queues[victim].pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Function: runTask
+ * -----------------
+ * Sorts the range of task on thread id: splits off the smaller part as
+ * a new task while the range is above PARALLEL_CUTOFF elements, then
+ * sorts the rest with introSort.
+ */
+void runTask(TaskPool & pool, int id, SortTask task) {
+  vector<long> & vec = *pool.vec;
+  int start = task.start, end = task.end, depth_limit = task.depth_limit;
+  while (end - start + 1 > PARALLEL_CUTOFF) {
+    if (depth_limit == 0) {
+      heapSort(vec, start, end);
+      return;
+    }
+    depth_limit--;
+    int lt, gt;
+    partition3(vec, start, end, lt, gt);
+    SortTask part;
+    if (lt - start < end - gt) {
+      part.start = start;
+      part.end = lt - 1;
+      start = gt + 1;
+    } else {
+      part.start = gt + 1;
+      part.end = end;
+      end = lt - 1;
+    }
+    part.depth_limit = depth_limit;
+    pool.pending++;
+    lock_guard<mutex> guard((*pool.locks)[id]);
+    pool.queues[id].push_back(part);
+  }
+  introSort(vec, start, end, depth_limit);
+}
+
+/*
+ * Function: benchmark
+ * Usage: benchmark(numbers, max_threads);
+ * ---------------------------------------
+ * Sorts copies of numbers with the sort mode and with the parallel mode
+ * on 1, 2, 4, ... max_threads threads and prints the time of each run,
+ * its speedup over the sort mode and whether its result differs.
+ */
+void benchmark(vector<long> & numbers, int max_threads) {
+  typedef chrono::steady_clock Clock;
+  cout << "numbers: " << numbers.size() << endl;
+  vector<long> expected(numbers);
+  Clock::time_point start = Clock::now();
+  introSort(expected, 0, expected.size() - 1);
+  double sort_time = chrono::duration<double>(Clock::now() - start).count();
+  cout << "sort: " << sort_time << " s"
+       << (is_sorted(expected.begin(), expected.end()) ? "" : " NOT SORTED") << endl;
+  for (int threads = 1; ; threads = min(threads * 2, max_threads)) {
+    vector<long> vec(numbers);
+    start = Clock::now();
+    parallelSort(vec, threads);
+    double time = chrono::duration<double>(Clock::now() - start).count();
+    cout << threads << " threads: " << time << " s, speedup " << sort_time / time
+	 << (vec == expected ? "" : " MISMATCH") << endl;
+    if (threads == max_threads) break;
+  }
+}
+
+/*
+ * Function: randomNumbers
+ * -----------------------
+ * Fills vec with size random longs from a fixed seed, so every run of
+ * the benchmark sorts the same numbers.
+ */
+void randomNumbers(vector<long> & vec, long size) {
+  mt19937_64 generator(size);
+  vec.resize(size);
+  for (long i = 0; i < size; i++) vec[i] = generator();
+}
+
 /*
  * Function: readFile
  * Usage: vector<int> vec; readFile(vec);
@@ -143,7 +936,7 @@ void swap(vector<long> & vec, int i, int j) {
  * Asks for a file with numbers and reads the numbers into the vector;
  */
 void readFile(vector<long> & vec, ifstream & infile) {
-  int value;
+  long value;
   while (infile >> value) {
     vec.push_back(value);
   }
@@ -205,3 +998,36 @@ bool testFileName(ifstream & infile, string filename) {
   infile.open(filename.c_str());
   return !infile.fail();
 }
+
+int stringToInteger(string str) {
+  istringstream stream(str);
+  int value;
+  stream >> value;
+  if (stream.fail() || !(stream >> ws).eof()) {
+    cerr << "stringToInteger: Illegal integer format (" + str + ")";
+    return 1;
+  }
+  return value;
+}
+
+long stringToLong(string str) {
+  istringstream stream(str);
+  long value;
+  stream >> value;
+  if (stream.fail() || !(stream >> ws).eof()) {
+    cerr << "stringToLong: Illegal integer format (" + str + ")";
+    return 0;
+  }
+  return value;
+}
+
+double stringToReal(string str) {
+  istringstream stream(str);
+  double value;
+  stream >> value;
+  if (stream.fail() || !(stream >> ws).eof()) {
+    cerr << "stringToReal: Illegal real format (" + str + ")";
+    return 1;
+  }
+  return value;
+}
@@ -0,0 +1,128 @@
+/*
+ * File: RadixSort.h
+ * -----------------
+ * An LSD radix sort for the integer inputs of the quicksort, mergesort
+ * and inversions programs. The keys are sorted RADIX_BITS bits at a
+ * time, least significant digit first, and every pass moves the keys
+ * stably between the vector and one scratch buffer of the same size.
+ *
+ * RADIX_BITS is 11, so the counts of one digit (2048 of them) stay in
+ * the L1 cache and a 32 bit key needs three passes, a 64 bit key six.
+ * The counts of all digits are taken in a single read of the input
+ * before the first pass, and a pass is skipped when all keys have the
+ * same digit, which is common for the high digits of small numbers.
+ * Signed keys are sorted by their bits with the sign bit flipped, which
+ * orders the negative numbers before the others.
+ */
+
+#ifndef _RadixSort_h
+#define _RadixSort_h
+
+#include <vector>
+#include <algorithm>
+#include <stddef.h>
+
+const int RADIX_BITS = 11;
+const int RADIX_BUCKETS = 1 << RADIX_BITS;
+const unsigned long RADIX_MASK = RADIX_BUCKETS - 1;
+
+/*
+ * Function: radixKey
+ * ------------------
+ * Returns the bits of a signed number with the sign bit flipped, which
+ * compare as unsigned numbers like the signed numbers do.
+ */
+inline unsigned long radixKey(long value) {
+  return (unsigned long) value ^ (1UL << 63);
+}
+
+inline unsigned int radixKey(int value) {
+  return (unsigned int) value ^ (1U << 31);
+}
+
+/*
+ * Function: radixCounts
+ * ---------------------
+ * Turns the counts of one digit into the first output slot of every
+ * digit value. Returns false if all n keys have the same digit, so the
+ * pass can be skipped.
+ */
+inline bool radixCounts(size_t * counts, size_t n) {
+  size_t sum = 0;
+  for (int d = 0; d < RADIX_BUCKETS; d++) {
+    if (counts[d] == n) return false;
+    size_t count = counts[d];
+    counts[d] = sum;
+    sum += count;
+  }
+  return true;
+}
+
+/*
+ * Function: radixSort
+ * Usage: radixSort(vec);
+ *        radixSort(vec, &payload);
+ * --------------------------------
+ * Sorts the vector into increasing order. The key type T is any type
+ * radixKey accepts, and it sets the number of passes. If payload is
+ * given, it holds one element per key and moves along with the keys.
+ */
+template <typename T, typename P = int>
+inline void radixSort(std::vector<T> & vec, std::vector<P> * payload = NULL) {
+  const int passes = (8 * sizeof(T) + RADIX_BITS - 1) / RADIX_BITS;
+  size_t n = vec.size();
+  if (n < 2) return;
+  std::vector<size_t> counts(passes * RADIX_BUCKETS);
+  for (size_t i = 0; i < n; i++) {
+    unsigned long key = radixKey(vec[i]);
+    for (int p = 0; p < passes; p++) counts[p * RADIX_BUCKETS + ((key >> (p * RADIX_BITS)) & RADIX_MASK)]++;
+  }
+  std::vector<T> scratch(n);
+  std::vector<P> payload_scratch(payload != NULL ? n : 0);
+  T * src = &vec[0];
+  T * dst = &scratch[0];
+  P * src_payload = payload != NULL ? &(*payload)[0] : NULL;
+  P * dst_payload = payload != NULL ? &payload_scratch[0] : NULL;
+  for (int p = 0; p < passes; p++) {
+    size_t * slots = &counts[p * RADIX_BUCKETS];
+    if (!radixCounts(slots, n)) continue;
+    int shift = p * RADIX_BITS;
+    for (size_t i = 0; i < n; i++) {
+      size_t slot = slots[((unsigned long) radixKey(src[i]) >> shift) & RADIX_MASK]++;
+      dst[slot] = src[i];
+      if (src_payload != NULL) dst_payload[slot] = src_payload[i];
+    }
+    std::swap(src, dst);
+    std::swap(src_payload, dst_payload);
+  }
+  if (src != &vec[0]) {
+    vec.swap(scratch);
+    if (payload != NULL) payload -> swap(payload_scratch);
+  }
+}
+
+/*
+ * Function: radixRanks
+ * Usage: std::vector<int> ranks; int distinct = radixRanks(vec, ranks);
+ * ---------------------------------------------------------------------
+ * Stores in ranks[i] the rank of vec[i] among the distinct values of
+ * vec, counting from 1, so equal values get equal ranks, and returns the
+ * number of distinct values. A copy of vec is radix sorted with the
+ * indexes as payload, then the ranks are handed out in sorted order.
+ */
+inline int radixRanks(const std::vector<long> & vec, std::vector<int> & ranks) {
+  size_t n = vec.size();
+  ranks.assign(n, 0);
+  std::vector<long> keys(vec);
+  std::vector<int> indexes(n);
+  for (size_t i = 0; i < n; i++) indexes[i] = i;
+  radixSort(keys, &indexes);
+  int rank = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (i == 0 || keys[i] != keys[i - 1]) rank++;
+    ranks[indexes[i]] = rank;
+  }
+  return rank;
+}
+
+#endif
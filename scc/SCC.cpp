@@ -7,9 +7,44 @@
  * the vertex label in first column is the tail and the vertex label
  * in second column is the head.
  * The file can be specified as the first argument of the program,
- * or it is prompted for.
+ * or it is prompted for. It may also be a binary graph snapshot written
+ * by snapshot/MakeSnapshot, which is loaded without parsing.
  * The priogram writes the result to std output. It outputs the sizes
  * of the SCCs in the given graph, in decreasing order of sizes.
+ *
+ * An optional MODE argument after the file name selects the engine:
+ *   map   - the graph and its reverse are maps of sets and the depth
+ *           first searches are recursive (default)
+ *   csr   - the graph and its reverse are stored in compressed sparse
+ *           row form and the depth first searches use an explicit stack
+ *           and a bitset of visited nodes, so deep graphs cannot overflow
+ *           the call stack
+ *   tarjan - Tarjan's single pass algorithm with an explicit stack; only
+ *           the CSR graph itself is read, not its reverse
+ *   parallel [THREADS]
+ *         - parallel engine for THREADS threads (default: one per core):
+ *           trims nodes without incoming or outgoing edges, finds the
+ *           SCC of a well connected pivot by a forward and a backward
+ *           search, and then colors the rest, finishing with tarjan once
+ *           little of the graph is left
+ *   bench - runs the csr, tarjan and parallel engines on the graph, checks
+ *           that they agree and prints the time each of them takes
+ *   topk [K]
+ *         - prints the K largest SCC sizes (default 5). Kosaraju labels
+ *           every node with the number of its SCC and counts the nodes
+ *           per SCC; the K largest counts are selected with a heap of K
+ *           entries, so no member lists are kept
+ *   scaling [MAX_THREADS]
+ *         - runs the parallel engine with 1, 2, 4, ... MAX_THREADS threads
+ *           (default: one per core) and prints the speedup over tarjan
+ *   condense OUTFILE [EDGEFILE]
+ *         - builds the condensation of the graph, the DAG with one node
+ *           per SCC, then inserts the edges of EDGEFILE ("tail head" per
+ *           row) one at a time, merging SCCs and keeping a topological
+ *           order of the DAG up to date, and writes the DAG to OUTFILE as
+ *           a graph snapshot with the SCCs numbered in topological order.
+ *           Prints the five largest SCC sizes; the SCC and DAG edge
+ *           counts go to std error.
  */
 
 #include <iostream>
@@ -22,18 +57,98 @@
 #include <vector>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <algorithm>
+#include <queue>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../snapshot/GraphSnapshot.h"
 using namespace std;
 
 typedef set<int>::iterator SetIt;  // aliasing the multiset iterator type used
 typedef map<int, set<int> >::iterator MapIt;  // aliasing the map iterator type used
 typedef list<int>::reverse_iterator ListIt;  // aliasing the list *reverse* iterator type used
 
+/*
+ * Type: CsrGraph
+ * --------------
+ * A directed graph in compressed sparse row form. The heads of the edges
+ * leaving node v are targets[offsets[v]] to targets[offsets[v + 1] - 1].
+ * Node numbers run from 0 to offsets.size() - 2; nodes without any edge
+ * in either direction are not part of the graph.
+ */
+struct CsrGraph {
+  vector<int> offsets;
+  vector<int> targets;
+};
+
+/*
+ * Type: ParallelScc
+ * -----------------
+ * The state shared by the threads of the parallel engine. Every phase
+ * hands out its items, either all nodes or the nodes of frontier, in
+ * chunks of PARALLEL_CHUNK through next_item. Each thread collects the
+ * nodes it produces in its own out vector and the sizes of the SCCs it
+ * finds in its own sizes vector; the main thread merges them between the
+ * phases. marks holds the search marks of the pivot phase and the colors
+ * of the coloring phases.
+ */
+struct ParallelScc {
+  CsrGraph * graph;
+  CsrGraph * rgraph;
+  int threads;
+  int phase;
+  vector<atomic<char> > * active; // nodes not assigned to an SCC yet
+  vector<atomic<int> > * degrees; // active successors, for trimming
+  vector<atomic<int> > * rdegrees; // active predecessors
+  vector<atomic<int> > * marks;
+  vector<int> frontier;
+  atomic<int> next_item;
+  vector<vector<int> > out;
+  vector<vector<int> > sizes;
+};
+
+/*
+ * Type: Condensation
+ * ------------------
+ * The condensation DAG of a graph under edge insertion. SCCs that merge
+ * are joined with union-find: component[v] is the SCC v was assigned
+ * when the condensation was built (or added), and findComponent maps it
+ * to the SCC it belongs to now. The other vectors are indexed by SCC and
+ * only valid for the current SCCs. order is a topological order of the
+ * DAG: every DAG edge goes from a lower to a higher order. out and in
+ * hold the DAG edges; entries may name merged SCCs or repeat, and are
+ * resolved with findComponent when they are used. forward_mark and
+ * backward_mark record the SCCs the two searches of insertEdge reached;
+ * a mark counts if it equals stamp, which each insertion increments.
+ * next_order is one more than the largest order, the position of the
+ * next SCC added.
+ */
+struct Condensation {
+  vector<int> component;
+  vector<int> parent;
+  vector<int> sizes;
+  vector<int> order;
+  vector<vector<int> > out;
+  vector<vector<int> > in;
+  vector<int> forward_mark;
+  vector<int> backward_mark;
+  int stamp;
+  int next_order;
+};
+
 /* Function prototypes */
 
 string promptUserForFile(ifstream & infile, string prompt);
 bool testFileName(ifstream & infile, string filename);
 void readFile(map<int, set<int> > & graph, map<int, set<int> > & rgraph, ifstream & infile);
+bool readSnapshot(map<int, set<int> > & graph, map<int, set<int> > & rgraph, string filename);
 void print(map<int, set<int> > & mymap);
 void print_size(map<int, set<int> > & mymap);
 void print_biggest(map<int, set<int> > & scc);
@@ -41,6 +156,39 @@ void print_biggest(map<int, set<int> > & scc);
 void dfsloop(map<int, set<int> > & graph, list<int> & nodelist, map<int, set<int> > & scc, bool firstpass);
 void dfs(map<int, set<int> > & graph, int explored[], int node, int leader, list<int> & nodelist, map<int, set<int> > & scc);
 
+bool readFile(CsrGraph & graph, CsrGraph * rgraph, string filename);
+bool countEdges(const char * p, const char * end, vector<int> & degrees, vector<int> & rdegrees, CsrGraph * graph, CsrGraph * rgraph);
+const char * parseInteger(const char * p, const char * end, int & value);
+void reverseGraph(CsrGraph & graph, CsrGraph & rgraph);
+void kosaraju(CsrGraph & graph, CsrGraph & rgraph, vector<int> & sizes);
+void kosaraju(CsrGraph & graph, CsrGraph & rgraph, vector<int> & component, vector<int> & sizes);
+void finishingOrder(CsrGraph & graph, CsrGraph & rgraph, vector<int> & order);
+void tarjan(CsrGraph & graph, vector<int> & sizes);
+void tarjan(CsrGraph & graph, vector<char> & active, vector<int> & sizes);
+void parallelScc(CsrGraph & graph, CsrGraph & rgraph, vector<int> & sizes, int threads);
+int parallelPhase(ParallelScc & state, int phase);
+void parallelSccWorker(ParallelScc & state, int id);
+void benchmark(CsrGraph & graph, CsrGraph & rgraph);
+void scalingBenchmark(CsrGraph & graph, CsrGraph & rgraph, int max_threads);
+void buildCondensation(CsrGraph & graph, CsrGraph & rgraph, Condensation & dag);
+int addComponent(Condensation & dag, int node);
+int findComponent(Condensation & dag, int c);
+bool insertEdge(Condensation & dag, int tail, int head);
+void searchDag(Condensation & dag, int start, bool forward, int bound, vector<int> & found);
+void mergeComponents(Condensation & dag, int into, int c);
+void currentSizes(Condensation & dag, vector<int> & sizes);
+int dagEdges(Condensation & dag, vector<long long> & offsets, vector<int> & targets);
+bool writeCondensation(Condensation & dag, string filename);
+bool readEdges(vector<pair<int, int> > & edges, string filename);
+void print_biggest(vector<int> & sizes, int k = 5);
+void biggest(vector<int> & sizes, int k, vector<int> & top);
+int stringToInteger(string str);
+
+enum { PHASE_INIT, PHASE_TRIM, PHASE_FORWARD, PHASE_BACKWARD, PHASE_COLLECT,
+       PHASE_COLOR_INIT, PHASE_COLOR, PHASE_ROOTS, PHASE_COLOR_SCC };
+const int PARALLEL_CHUNK = 1024; // items a thread takes at a time
+const int SERIAL_LIMIT = 10000; // remaining nodes left to tarjan
+
 /* Main program */
 
 using namespace std;
@@ -50,8 +198,19 @@ int main(int argc, char* argv[]) {
   map<int, set<int> > scc;
   list<int> nodelist;
   ifstream infile;
+  string filename;
+  string mode = argc > 2 ? argv[2] : "map";
+  if (mode != "map" && mode != "csr" && mode != "tarjan" && mode != "parallel" &&
+      mode != "bench" && mode != "scaling" && mode != "topk" && mode != "condense") {
+    cerr << "Unknown mode: " << mode << "\n"
+	 << "Usage: " << argv[0] << " FILENAME [map|csr|tarjan|bench]\n"
+	 << "       " << argv[0] << " FILENAME topk [K]\n"
+	 << "       " << argv[0] << " FILENAME condense OUTFILE [EDGEFILE]\n"
+	 << "       " << argv[0] << " FILENAME parallel|scaling [THREADS]" << endl;
+    return 1;
+  }
   if (argc < 2) {
-    promptUserForFile(infile, "Input file: ");
+    filename = promptUserForFile(infile, "Input file: ");
   }
   else {
     if (!testFileName(infile, argv[1])) {
@@ -59,8 +218,75 @@ int main(int argc, char* argv[]) {
 	   <<"Usage: " << argv[0] << " FILENAME" << endl;
       return 1;
     }
+    filename = argv[1];
+  }
+  if (mode == "condense" && argc < 4) {
+    cerr << "Missing output file\n"
+	 << "Usage: " << argv[0] << " FILENAME condense OUTFILE [EDGEFILE]" << endl;
+    return 1;
+  }
+  if (mode != "map") {
+    infile.close();
+    CsrGraph csr_graph, csr_rgraph;
+    if (!readFile(csr_graph, mode == "tarjan" ? NULL : &csr_rgraph, filename)) {
+      cerr << "Unable to read " << filename << endl;
+      return 1;
+    }
+    if (mode == "bench") {
+      benchmark(csr_graph, csr_rgraph);
+      return 0;
+    }
+    if (mode == "topk") {
+      int k = argc > 3 ? stringToInteger(argv[3]) : 5;
+      vector<int> component, sizes;
+      kosaraju(csr_graph, csr_rgraph, component, sizes);
+      print_biggest(sizes, max(k, 0));
+      return 0;
+    }
+    if (mode == "condense") {
+      vector<pair<int, int> > edges;
+      if (argc > 4 && !readEdges(edges, argv[4])) {
+	cerr << "Unable to read " << argv[4] << endl;
+	return 1;
+      }
+      Condensation dag;
+      buildCondensation(csr_graph, csr_rgraph, dag);
+      for (size_t i = 0; i < edges.size(); i++) {
+	if (!insertEdge(dag, edges[i].first, edges[i].second)) {
+	  cerr << "Invalid edge: " << edges[i].first << " " << edges[i].second << endl;
+	  return 1;
+	}
+      }
+      if (!writeCondensation(dag, argv[3])) {
+	cerr << "Unable to write " << argv[3] << endl;
+	return 1;
+      }
+      vector<int> sizes;
+      currentSizes(dag, sizes);
+      print_biggest(sizes);
+      return 0;
+    }
+    int threads = argc > 3 ? stringToInteger(argv[3]) : thread::hardware_concurrency();
+    if (mode == "scaling") {
+      scalingBenchmark(csr_graph, csr_rgraph, max(threads, 1));
+      return 0;
+    }
+    vector<int> sizes;
+    if (mode == "tarjan") tarjan(csr_graph, sizes);
+    else if (mode == "parallel") parallelScc(csr_graph, csr_rgraph, sizes, max(threads, 1));
+    else kosaraju(csr_graph, csr_rgraph, sizes);
+    print_biggest(sizes);
+    return 0;
+  }
+  if (isSnapshot(filename)) {
+    infile.close();
+    if (!readSnapshot(graph, rgraph, filename)) {
+      cerr << "Unable to read " << filename << endl;
+      return 1;
+    }
+  } else {
+    readFile(graph, rgraph, infile);
   }
-  readFile(graph, rgraph, infile);
 
   dfsloop(rgraph, nodelist, scc, true);
   dfsloop(graph, nodelist, scc, false);
@@ -119,6 +345,742 @@ void dfs(map<int, set<int> > & graph, int explored[], int node, int leader, list
   nodelist.push_back(node);
 }
 
+/*
+ * Function: kosaraju
+ * Usage: vector<int> sizes; kosaraju(graph, rgraph, sizes);
+ * ---------------------------------------------------------
+ * Returns the sizes of the SCCs in sizes, in the order they are found.
+ * It runs the labelling kosaraju below and drops the labels.
+ */
+void kosaraju(CsrGraph & graph, CsrGraph & rgraph, vector<int> & sizes) {
+  vector<int> component;
+  kosaraju(graph, rgraph, component, sizes);
+}
+
+/*
+ * Function: kosaraju
+ * Usage: vector<int> component, sizes; kosaraju(graph, rgraph, component, sizes);
+ * -------------------------------------------------------------------------------
+ * Kosaraju's two passes on CSR graphs with an explicit stack instead of
+ * recursion. The first pass, finishingOrder, runs depth first searches
+ * on the reverse graph and records the nodes in order of their finishing
+ * times; the second pass runs them on the graph in decreasing finishing
+ * time, and every search of the second pass visits exactly one SCC.
+ * component[v] is the number of the SCC of v, counting from 0 in the
+ * order the SCCs are found, or -1 for nodes that are not part of the
+ * graph; the labels also mark the nodes the second pass has visited.
+ * sizes[c] counts the nodes of SCC c.
+ */
+void kosaraju(CsrGraph & graph, CsrGraph & rgraph, vector<int> & component, vector<int> & sizes) {
+  int graph_size = graph.offsets.size() - 1;
+  vector<int> order;
+  finishingOrder(graph, rgraph, order);
+  component.assign(graph_size, -1);
+  vector<int> todo;
+  sizes.clear();
+  for (int i = order.size() - 1; i >= 0; i--) {
+    int leader = order[i];
+    if (component[leader] != -1) continue;
+    int id = sizes.size();
+    sizes.push_back(0);
+    component[leader] = id;
+    todo.push_back(leader);
+    while (!todo.empty()) {
+      int node = todo.back();
+      todo.pop_back();
+      sizes[id]++;
+      for (int e = graph.offsets[node]; e < graph.offsets[node + 1]; e++) {
+	if (component[graph.targets[e]] == -1) {
+	  component[graph.targets[e]] = id;
+	  todo.push_back(graph.targets[e]);
+	}
+      }
+    }
+  }
+}
+
+/*
+ * Function: finishingOrder
+ * Usage: vector<int> order; finishingOrder(graph, rgraph, order);
+ * ---------------------------------------------------------------
+ * The first pass of kosaraju: depth first searches on the reverse graph
+ * from every node of the graph, returning the nodes in increasing order
+ * of their finishing times.
+ */
+void finishingOrder(CsrGraph & graph, CsrGraph & rgraph, vector<int> & order) {
+  int graph_size = graph.offsets.size() - 1;
+  vector<bool> explored(graph_size, false);
+  order.clear();
+  order.reserve(graph_size);
+  vector<pair<int, int> > stack;
+  for (int v = 0; v < graph_size; v++) {
+    if (explored[v]) continue;
+    if (graph.offsets[v] == graph.offsets[v + 1] && rgraph.offsets[v] == rgraph.offsets[v + 1]) continue;
+    explored[v] = true;
+    stack.push_back(make_pair(v, rgraph.offsets[v]));
+    while (!stack.empty()) {
+      int node = stack.back().first;
+      int & edge = stack.back().second;
+      if (edge == rgraph.offsets[node + 1]) {
+	order.push_back(node);
+	stack.pop_back();
+	continue;
+      }
+      int next = rgraph.targets[edge++];
+      if (!explored[next]) {
+	explored[next] = true;
+	stack.push_back(make_pair(next, rgraph.offsets[next]));
+      }
+    }
+  }
+}
+
+/*
+ * Function: buildCondensation
+ * Usage: Condensation dag; buildCondensation(graph, rgraph, dag);
+ * ---------------------------------------------------------------
+ * Labels the nodes with kosaraju and collects the edges between different
+ * SCCs. Kosaraju finds every SCC before the SCCs that have edges into it,
+ * so numbering the SCCs backwards gives the initial topological order.
+ */
+void buildCondensation(CsrGraph & graph, CsrGraph & rgraph, Condensation & dag) {
+  kosaraju(graph, rgraph, dag.component, dag.sizes);
+  int count = dag.sizes.size();
+  dag.parent.resize(count);
+  dag.order.resize(count);
+  for (int c = 0; c < count; c++) {
+    dag.parent[c] = c;
+    dag.order[c] = count - 1 - c;
+  }
+  dag.out.assign(count, vector<int>());
+  dag.in.assign(count, vector<int>());
+  dag.forward_mark.assign(count, 0);
+  dag.backward_mark.assign(count, 0);
+  dag.stamp = 0;
+  dag.next_order = count;
+  int graph_size = graph.offsets.size() - 1;
+  for (int v = 0; v < graph_size; v++) {
+    for (int e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+      int from = dag.component[v], to = dag.component[graph.targets[e]];
+      if (from != to) dag.out[from].push_back(to);
+    }
+  }
+  for (int c = 0; c < count; c++) {
+    sort(dag.out[c].begin(), dag.out[c].end());
+    dag.out[c].erase(unique(dag.out[c].begin(), dag.out[c].end()), dag.out[c].end());
+    for (size_t i = 0; i < dag.out[c].size(); i++) dag.in[dag.out[c][i]].push_back(c);
+  }
+}
+
+/*
+ * Function: addComponent
+ * Usage: int c = addComponent(dag, node);
+ * ---------------------------------------
+ * Returns the current SCC of node. A node that is new to the graph gets
+ * an SCC of its own at the end of the topological order.
+ */
+int addComponent(Condensation & dag, int node) {
+  if (node >= (int) dag.component.size()) dag.component.resize(node + 1, -1);
+  if (dag.component[node] == -1) {
+    int c = dag.parent.size();
+    dag.component[node] = c;
+    dag.parent.push_back(c);
+    dag.sizes.push_back(1);
+    dag.order.push_back(dag.next_order++);
+    dag.out.push_back(vector<int>());
+    dag.in.push_back(vector<int>());
+    dag.forward_mark.push_back(0);
+    dag.backward_mark.push_back(0);
+  }
+  return findComponent(dag, dag.component[node]);
+}
+
+/*
+ * Function: findComponent
+ * Usage: int current = findComponent(dag, c);
+ * -------------------------------------------
+ * Returns the SCC that SCC c has been merged into, halving the paths of
+ * the union-find forest on the way.
+ */
+int findComponent(Condensation & dag, int c) {
+  while (dag.parent[c] != c) {
+    dag.parent[c] = dag.parent[dag.parent[c]];
+    c = dag.parent[c];
+  }
+  return c;
+}
+
+/*
+ * Function: insertEdge
+ * Usage: insertEdge(dag, tail, head);
+ * -----------------------------------
+ * Adds the edge tail -> head to the graph of the condensation. This is
+ * the algorithm of Pearce and Kelly: an edge from SCC x to SCC y that
+ * agrees with the topological order is simply added. Otherwise only the
+ * SCCs between y and x in the order are affected: F, those reachable
+ * from y, and B, those reaching x. If F contains x the new edge closes
+ * cycles and the SCCs in both F and B merge into x; the rest of B and F
+ * then take over the order positions of B and F, B first.
+ * Returns false, leaving the DAG unchanged, if a node number is negative.
+ */
+bool insertEdge(Condensation & dag, int tail, int head) {
+  if (tail < 0 || head < 0) return false;
+  int x = addComponent(dag, tail);
+  int y = addComponent(dag, head);
+  if (x == y) return true;
+  if (dag.order[x] < dag.order[y]) {
+    dag.out[x].push_back(y);
+    dag.in[y].push_back(x);
+    return true;
+  }
+  dag.stamp++;
+  vector<int> forward, backward;
+  searchDag(dag, y, true, dag.order[x], forward);
+  searchDag(dag, x, false, dag.order[y], backward);
+  bool cycle = dag.forward_mark[x] == dag.stamp;
+
+  vector<int> positions;
+  vector<pair<int, int> > before, after; // (order, SCC) of B and of F, without merged SCCs
+  for (size_t i = 0; i < backward.size(); i++) {
+    int c = backward[i];
+    positions.push_back(dag.order[c]);
+    if (dag.forward_mark[c] != dag.stamp) before.push_back(make_pair(dag.order[c], c));
+  }
+  for (size_t i = 0; i < forward.size(); i++) {
+    int c = forward[i];
+    if (dag.backward_mark[c] == dag.stamp) continue; // listed with B
+    positions.push_back(dag.order[c]);
+    after.push_back(make_pair(dag.order[c], c));
+  }
+  sort(positions.begin(), positions.end());
+  sort(before.begin(), before.end());
+  sort(after.begin(), after.end());
+
+  // B takes the lowest positions and F the highest, so B only moves down
+  // and F only moves up and the edges to the other SCCs stay in order
+  for (size_t i = 0; i < before.size(); i++) dag.order[before[i].second] = positions[i];
+  for (size_t i = 0; i < after.size(); i++) {
+    dag.order[after[i].second] = positions[positions.size() - after.size() + i];
+  }
+  if (!cycle) {
+    dag.out[x].push_back(y);
+    dag.in[y].push_back(x);
+    return true;
+  }
+  for (size_t i = 0; i < backward.size(); i++) {
+    int c = backward[i];
+    if (c != x && dag.forward_mark[c] == dag.stamp) mergeComponents(dag, x, c);
+  }
+  dag.order[x] = positions[before.size()];
+  vector<int> * lists[2] = { &dag.out[x], &dag.in[x] };
+  for (int l = 0; l < 2; l++) {
+    vector<int> & list = *lists[l];
+    for (size_t i = 0; i < list.size(); i++) list[i] = findComponent(dag, list[i]);
+    sort(list.begin(), list.end());
+    list.erase(unique(list.begin(), list.end()), list.end());
+    list.erase(remove(list.begin(), list.end(), x), list.end());
+  }
+  return true;
+}
+
+/*
+ * Function: searchDag
+ * Usage: searchDag(dag, start, true, bound, found);
+ * -------------------------------------------------
+ * Depth first search from SCC start along the DAG edges, or against them
+ * if forward is false, that only enters SCCs whose order is at most bound
+ * (forward) or at least bound (backward). Returns the SCCs reached in
+ * found and marks them with the current stamp.
+ */
+void searchDag(Condensation & dag, int start, bool forward, int bound, vector<int> & found) {
+  vector<int> & mark = forward ? dag.forward_mark : dag.backward_mark;
+  vector<int> todo(1, start);
+  mark[start] = dag.stamp;
+  while (!todo.empty()) {
+    int c = todo.back();
+    todo.pop_back();
+    found.push_back(c);
+    vector<int> & edges = forward ? dag.out[c] : dag.in[c];
+    for (size_t i = 0; i < edges.size(); i++) {
+      int next = findComponent(dag, edges[i]);
+      if (next == c || mark[next] == dag.stamp) continue;
+      if (forward ? dag.order[next] > bound : dag.order[next] < bound) continue;
+      mark[next] = dag.stamp;
+      todo.push_back(next);
+    }
+  }
+}
+
+/*
+ * Function: mergeComponents
+ * Usage: mergeComponents(dag, into, c);
+ * -------------------------------------
+ * Merges SCC c into SCC into, which takes over its nodes and DAG edges.
+ */
+void mergeComponents(Condensation & dag, int into, int c) {
+  dag.parent[c] = into;
+  dag.sizes[into] += dag.sizes[c];
+  dag.sizes[c] = 0;
+  dag.out[into].insert(dag.out[into].end(), dag.out[c].begin(), dag.out[c].end());
+  dag.in[into].insert(dag.in[into].end(), dag.in[c].begin(), dag.in[c].end());
+  vector<int>().swap(dag.out[c]);
+  vector<int>().swap(dag.in[c]);
+}
+
+/*
+ * Function: currentSizes
+ * Usage: vector<int> sizes; currentSizes(dag, sizes);
+ * ---------------------------------------------------
+ * Returns the sizes of the current SCCs of the condensation.
+ */
+void currentSizes(Condensation & dag, vector<int> & sizes) {
+  sizes.clear();
+  for (size_t c = 0; c < dag.parent.size(); c++) {
+    if (dag.parent[c] == (int) c) sizes.push_back(dag.sizes[c]);
+  }
+}
+
+/*
+ * Function: dagEdges
+ * Usage: int count = dagEdges(dag, offsets, targets);
+ * ---------------------------------------------------
+ * Builds the DAG in CSR form with the current SCCs numbered 0, 1, ... in
+ * topological order, so every edge goes from a lower to a higher number.
+ * Returns the number of SCCs.
+ */
+int dagEdges(Condensation & dag, vector<long long> & offsets, vector<int> & targets) {
+  vector<pair<int, int> > roots; // (order, SCC)
+  for (size_t c = 0; c < dag.parent.size(); c++) {
+    if (dag.parent[c] == (int) c) roots.push_back(make_pair(dag.order[c], c));
+  }
+  sort(roots.begin(), roots.end());
+  vector<int> number(dag.parent.size(), -1);
+  for (size_t i = 0; i < roots.size(); i++) number[roots[i].second] = i;
+  offsets.assign(1, 0);
+  targets.clear();
+  vector<int> row;
+  for (size_t i = 0; i < roots.size(); i++) {
+    vector<int> & edges = dag.out[roots[i].second];
+    row.clear();
+    for (size_t j = 0; j < edges.size(); j++) {
+      int next = findComponent(dag, edges[j]);
+      if (next != roots[i].second) row.push_back(number[next]);
+    }
+    sort(row.begin(), row.end());
+    row.erase(unique(row.begin(), row.end()), row.end());
+    targets.insert(targets.end(), row.begin(), row.end());
+    offsets.push_back(targets.size());
+  }
+  return roots.size();
+}
+
+/*
+ * Function: writeCondensation
+ * Usage: writeCondensation(dag, filename);
+ * ----------------------------------------
+ * Writes the DAG built by dagEdges as an unweighted graph snapshot and
+ * prints the number of SCCs and DAG edges to std error. Returns false
+ * if the file cannot be written.
+ */
+bool writeCondensation(Condensation & dag, string filename) {
+  vector<long long> offsets;
+  vector<int> targets, weights;
+  int count = dagEdges(dag, offsets, targets);
+  vector<unsigned char> present(count, 1);
+  cerr << "sccs: " << count << " dag edges: " << targets.size() << endl;
+  return writeSnapshot(filename, offsets, targets, weights, present);
+}
+
+/*
+ * Function: readEdges
+ * Usage: vector<pair<int, int> > edges; readEdges(edges, filename);
+ * -----------------------------------------------------------------
+ * Reads the "tail head" rows of a file of edges to insert. Returns false
+ * if the file cannot be opened or has a negative node number, which is
+ * reported with its row.
+ */
+bool readEdges(vector<pair<int, int> > & edges, string filename) {
+  ifstream edgefile(filename.c_str());
+  if (edgefile.fail()) return false;
+  int tail, head;
+  while (edgefile >> tail >> head) {
+    if (tail < 0 || head < 0) {
+      cerr << "Negative node number in row " << edges.size() + 1 << ": " << tail << " " << head << endl;
+      return false;
+    }
+    edges.push_back(make_pair(tail, head));
+  }
+  return true;
+}
+
+/*
+ * Function: tarjan
+ * Usage: vector<int> sizes; tarjan(graph, sizes);
+ * -----------------------------------------------
+ * Tarjan's algorithm: a single depth first search pass over the graph
+ * that numbers the nodes in the order they are reached and keeps for
+ * every node the lowest number reachable from it through the nodes still
+ * on the SCC stack. A node whose lowest number is its own number is the
+ * root of an SCC, which consists of the nodes above it on the SCC stack.
+ * As in kosaraju the search uses an explicit (node, next edge) stack.
+ * The sizes of the SCCs are returned in sizes, in the order they are
+ * found.
+ */
+void tarjan(CsrGraph & graph, vector<int> & sizes) {
+  int graph_size = graph.offsets.size() - 1;
+  vector<char> active(graph_size, 0);
+  for (int v = 0; v < graph_size; v++) {
+    if (graph.offsets[v] < graph.offsets[v + 1]) active[v] = 1;
+  }
+  for (size_t e = 0; e < graph.targets.size(); e++) active[graph.targets[e]] = 1;
+  sizes.clear();
+  tarjan(graph, active, sizes);
+}
+
+/*
+ * Function: tarjan
+ * Usage: tarjan(graph, active, sizes);
+ * ------------------------------------
+ * Runs Tarjan's algorithm on the subgraph of the active nodes and appends
+ * the sizes of its SCCs to sizes.
+ */
+void tarjan(CsrGraph & graph, vector<char> & active, vector<int> & sizes) {
+  int graph_size = graph.offsets.size() - 1;
+  vector<int> index(graph_size, -1); // order in which the nodes are reached
+  vector<int> lowlink(graph_size);
+  vector<bool> on_stack(graph_size, false);
+  vector<int> scc_stack;
+  vector<pair<int, int> > stack;
+  int counter = 0;
+  for (int v = 0; v < graph_size; v++) {
+    if (index[v] != -1 || !active[v]) continue;
+    index[v] = lowlink[v] = counter++;
+    scc_stack.push_back(v);
+    on_stack[v] = true;
+    stack.push_back(make_pair(v, graph.offsets[v]));
+    while (!stack.empty()) {
+      int node = stack.back().first;
+      int & edge = stack.back().second;
+      if (edge < graph.offsets[node + 1]) {
+	int next = graph.targets[edge++];
+	if (!active[next]) continue;
+	if (index[next] == -1) {
+	  index[next] = lowlink[next] = counter++;
+	  scc_stack.push_back(next);
+	  on_stack[next] = true;
+	  stack.push_back(make_pair(next, graph.offsets[next]));
+	} else if (on_stack[next]) {
+	  lowlink[node] = min(lowlink[node], index[next]);
+	}
+	continue;
+      }
+      stack.pop_back();
+      if (!stack.empty()) {
+	int parent = stack.back().first;
+	lowlink[parent] = min(lowlink[parent], lowlink[node]);
+      }
+      if (lowlink[node] == index[node]) {
+	int size = 0;
+	int member;
+	do {
+	  member = scc_stack.back();
+	  scc_stack.pop_back();
+	  on_stack[member] = false;
+	  size++;
+	} while (member != node);
+	sizes.push_back(size);
+      }
+    }
+  }
+}
+
+/*
+ * Function: parallelScc
+ * Usage: vector<int> sizes; parallelScc(graph, rgraph, sizes, threads);
+ * ---------------------------------------------------------------------
+ * Finds the SCCs with threads threads in three steps:
+ * 1. Trim: a node without active predecessors or without active
+ *    successors is an SCC of its own. Removing it lowers the degrees of
+ *    its neighbours, which are trimmed in turn once a degree drops to 0.
+ * 2. Pivot: the nodes that the active node with the largest product of
+ *    degrees reaches both by a forward and by a backward search form its
+ *    SCC, which in most real graphs is the one giant SCC.
+ * 3. Coloring: every active node starts with its own number as color and
+ *    the largest colors are pushed along the edges until nothing changes.
+ *    A node that kept its own color is the root of the nodes with that
+ *    color, and the nodes of its color that reach it form its SCC.
+ *    The coloring is repeated on the nodes left over; once fewer than
+ *    SERIAL_LIMIT nodes remain or a round removes less than 1% of them,
+ *    tarjan finishes the rest.
+ * The searches are level synchronous: each level of a search is one
+ * parallel phase over the current frontier. The sizes of the SCCs are
+ * returned in sizes in no particular order.
+ */
+void parallelScc(CsrGraph & graph, CsrGraph & rgraph, vector<int> & sizes, int threads) {
+  int graph_size = graph.offsets.size() - 1;
+  vector<atomic<char> > active(graph_size);
+  vector<atomic<int> > degrees(graph_size), rdegrees(graph_size), marks(graph_size);
+  ParallelScc state;
+  state.graph = &graph;
+  state.rgraph = &rgraph;
+  state.threads = threads;
+  state.active = &active;
+  state.degrees = &degrees;
+  state.rdegrees = &rdegrees;
+  state.marks = &marks;
+  state.out.resize(threads);
+  state.sizes.resize(threads);
+
+  int remaining = parallelPhase(state, PHASE_INIT); // nodes with zero degrees in frontier
+  while (!state.frontier.empty()) remaining -= parallelPhase(state, PHASE_TRIM);
+
+  if (remaining > 0) {
+    int pivot = -1;
+    long long best = -1;
+    for (int v = 0; v < graph_size; v++) {
+      if (!active[v].load(memory_order_relaxed)) continue;
+      long long score = (long long) degrees[v].load(memory_order_relaxed) * rdegrees[v].load(memory_order_relaxed);
+      if (score > best) {
+	best = score;
+	pivot = v;
+      }
+    }
+    marks[pivot].store(3, memory_order_relaxed);
+    state.frontier.assign(1, pivot);
+    while (!state.frontier.empty()) parallelPhase(state, PHASE_FORWARD);
+    state.frontier.assign(1, pivot);
+    while (!state.frontier.empty()) parallelPhase(state, PHASE_BACKWARD);
+    remaining -= parallelPhase(state, PHASE_COLLECT);
+  }
+
+  while (remaining > SERIAL_LIMIT) {
+    parallelPhase(state, PHASE_COLOR_INIT);
+    while (!state.frontier.empty()) parallelPhase(state, PHASE_COLOR);
+    parallelPhase(state, PHASE_ROOTS);
+    int removed = parallelPhase(state, PHASE_COLOR_SCC);
+    remaining -= removed;
+    if (removed * 100LL < remaining) break;
+  }
+
+  sizes.clear();
+  for (int i = 0; i < threads; i++) sizes.insert(sizes.end(), state.sizes[i].begin(), state.sizes[i].end());
+  if (remaining > 0) {
+    vector<char> rest(graph_size);
+    for (int v = 0; v < graph_size; v++) rest[v] = active[v].load(memory_order_relaxed);
+    tarjan(graph, rest, sizes);
+  }
+}
+
+/*
+ * Function: parallelPhase
+ * Usage: int removed = parallelPhase(state, PHASE_TRIM);
+ * ------------------------------------------------------
+ * Runs one phase on state.threads threads, or on the calling thread
+ * alone if there are too few items to share, and makes the nodes the
+ * threads collected the new frontier. Returns the number of nodes the
+ * phase assigned to SCCs; PHASE_INIT returns the number of active nodes.
+ */
+int parallelPhase(ParallelScc & state, int phase) {
+  int graph_size = state.graph -> offsets.size() - 1;
+  bool node_phase = phase == PHASE_INIT || phase == PHASE_COLLECT || phase == PHASE_COLOR_INIT || phase == PHASE_ROOTS;
+  int items = node_phase ? graph_size : state.frontier.size();
+  vector<int> found_before(state.threads);
+  for (int i = 0; i < state.threads; i++) {
+    state.out[i].clear();
+    found_before[i] = state.sizes[i].size();
+  }
+  state.phase = phase;
+  state.next_item.store(0);
+  if (state.threads == 1 || items <= PARALLEL_CHUNK) {
+    parallelSccWorker(state, 0);
+  } else {
+    vector<thread> workers;
+    for (int i = 1; i < state.threads; i++) workers.push_back(thread(parallelSccWorker, ref(state), i));
+    parallelSccWorker(state, 0);
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+  }
+  int result = 0;
+  state.frontier.clear();
+  for (int i = 0; i < state.threads; i++) {
+    state.frontier.insert(state.frontier.end(), state.out[i].begin(), state.out[i].end());
+    for (size_t j = found_before[i]; j < state.sizes[i].size(); j++) result += state.sizes[i][j];
+  }
+  if (phase == PHASE_INIT || phase == PHASE_COLLECT) {
+    // the threads record their share of the active nodes or of the pivot
+    // SCC as a size, which are merged here
+    for (int i = 0; i < state.threads; i++) state.sizes[i].resize(found_before[i]);
+    if (phase == PHASE_COLLECT && result > 0) state.sizes[0].push_back(result);
+  }
+  return result;
+}
+
+/*
+ * Function: parallelSccWorker
+ * Usage: thread(parallelSccWorker, ref(state), id);
+ * -------------------------------------------------
+ * Processes chunks of the items of the current phase until none are
+ * left. Nodes are claimed with atomic operations, so a node enters an
+ * SCC or the next frontier of a search only once.
+ */
+void parallelSccWorker(ParallelScc & state, int id) {
+  CsrGraph & graph = *state.graph;
+  CsrGraph & rgraph = *state.rgraph;
+  vector<atomic<char> > & active = *state.active;
+  vector<atomic<int> > & degrees = *state.degrees;
+  vector<atomic<int> > & rdegrees = *state.rdegrees;
+  vector<atomic<int> > & marks = *state.marks;
+  vector<int> & out = state.out[id];
+  vector<int> & sizes = state.sizes[id];
+  int phase = state.phase;
+  bool node_phase = phase == PHASE_INIT || phase == PHASE_COLLECT || phase == PHASE_COLOR_INIT || phase == PHASE_ROOTS;
+  int items = node_phase ? graph.offsets.size() - 1 : state.frontier.size();
+  int count = 0;
+  vector<int> queue; // nodes of the SCC being collected in PHASE_COLOR_SCC
+  while (true) {
+    int begin = state.next_item.fetch_add(PARALLEL_CHUNK);
+    if (begin >= items) break;
+    int end = min(begin + PARALLEL_CHUNK, items);
+    for (int i = begin; i < end; i++) {
+      int node = node_phase ? i : state.frontier[i];
+      if (phase == PHASE_INIT) {
+	int degree = graph.offsets[node + 1] - graph.offsets[node];
+	int rdegree = rgraph.offsets[node + 1] - rgraph.offsets[node];
+	degrees[node].store(degree, memory_order_relaxed);
+	rdegrees[node].store(rdegree, memory_order_relaxed);
+	marks[node].store(0, memory_order_relaxed);
+	active[node].store(degree > 0 || rdegree > 0, memory_order_relaxed);
+	if (degree == 0 && rdegree == 0) continue;
+	count++;
+	if (degree == 0 || rdegree == 0) out.push_back(node);
+      } else if (phase == PHASE_TRIM) {
+	if (!active[node].exchange(0)) continue;
+	sizes.push_back(1);
+	for (int e = graph.offsets[node]; e < graph.offsets[node + 1]; e++) {
+	  int next = graph.targets[e];
+	  if (active[next].load(memory_order_relaxed) && rdegrees[next].fetch_sub(1) == 1) out.push_back(next);
+	}
+	for (int e = rgraph.offsets[node]; e < rgraph.offsets[node + 1]; e++) {
+	  int next = rgraph.targets[e];
+	  if (active[next].load(memory_order_relaxed) && degrees[next].fetch_sub(1) == 1) out.push_back(next);
+	}
+      } else if (phase == PHASE_FORWARD || phase == PHASE_BACKWARD) {
+	CsrGraph & search_graph = phase == PHASE_FORWARD ? graph : rgraph;
+	int bit = phase == PHASE_FORWARD ? 1 : 2;
+	for (int e = search_graph.offsets[node]; e < search_graph.offsets[node + 1]; e++) {
+	  int next = search_graph.targets[e];
+	  if (active[next].load(memory_order_relaxed) && !(marks[next].fetch_or(bit) & bit)) out.push_back(next);
+	}
+      } else if (phase == PHASE_COLLECT) {
+	if (marks[node].load(memory_order_relaxed) == 3) {
+	  active[node].store(0, memory_order_relaxed);
+	  count++;
+	}
+      } else if (phase == PHASE_COLOR_INIT) {
+	if (!active[node].load(memory_order_relaxed)) continue;
+	marks[node].store(node, memory_order_relaxed);
+	out.push_back(node);
+      } else if (phase == PHASE_COLOR) {
+	int color = marks[node].load(memory_order_relaxed);
+	for (int e = graph.offsets[node]; e < graph.offsets[node + 1]; e++) {
+	  int next = graph.targets[e];
+	  if (!active[next].load(memory_order_relaxed)) continue;
+	  int old_color = marks[next].load(memory_order_relaxed);
+	  while (old_color < color && !marks[next].compare_exchange_weak(old_color, color, memory_order_relaxed));
+	  if (old_color < color) out.push_back(next);
+	}
+      } else if (phase == PHASE_ROOTS) {
+	if (active[node].load(memory_order_relaxed) && marks[node].load(memory_order_relaxed) == node) out.push_back(node);
+      } else if (phase == PHASE_COLOR_SCC) {
+	// only this thread touches the nodes of this color
+	queue.assign(1, node);
+	marks[node].store(-1, memory_order_relaxed);
+	for (size_t q = 0; q < queue.size(); q++) {
+	  int member = queue[q];
+	  active[member].store(0, memory_order_relaxed);
+	  for (int e = rgraph.offsets[member]; e < rgraph.offsets[member + 1]; e++) {
+	    int next = rgraph.targets[e];
+	    if (marks[next].load(memory_order_relaxed) == node && active[next].load(memory_order_relaxed)) {
+	      marks[next].store(-1, memory_order_relaxed);
+	      queue.push_back(next);
+	    }
+	  }
+	}
+	sizes.push_back(queue.size());
+      }
+    }
+  }
+  if (phase == PHASE_INIT) sizes.push_back(count);
+  if (phase == PHASE_COLLECT && count > 0) sizes.push_back(count);
+}
+
+/*
+ * Function: benchmark
+ * Usage: benchmark(graph, rgraph);
+ * --------------------------------
+ * Runs the csr and tarjan engines on the graph and prints the time each
+ * of them takes, not counting the time to read the file. The SCC sizes
+ * of tarjan are compared with those of the csr engine. The recursive map
+ * engine is left out since it overflows the stack on large graphs.
+ */
+void benchmark(CsrGraph & graph, CsrGraph & rgraph) {
+  typedef chrono::steady_clock Clock;
+  cout << "nodes: " << graph.offsets.size() - 1 << " edges: " << graph.targets.size() << endl;
+
+  vector<int> expected;
+  Clock::time_point start = Clock::now();
+  kosaraju(graph, rgraph, expected);
+  double csr_time = chrono::duration<double>(Clock::now() - start).count();
+
+  vector<int> tarjan_sizes;
+  start = Clock::now();
+  tarjan(graph, tarjan_sizes);
+  double tarjan_time = chrono::duration<double>(Clock::now() - start).count();
+
+  int threads = max((int) thread::hardware_concurrency(), 1);
+  vector<int> parallel_sizes;
+  start = Clock::now();
+  parallelScc(graph, rgraph, parallel_sizes, threads);
+  double parallel_time = chrono::duration<double>(Clock::now() - start).count();
+
+  sort(expected.begin(), expected.end());
+  sort(tarjan_sizes.begin(), tarjan_sizes.end());
+  sort(parallel_sizes.begin(), parallel_sizes.end());
+  cout << "sccs: " << expected.size() << endl;
+  cout << "csr:      " << csr_time << " s" << endl;
+  cout << "tarjan:   " << tarjan_time << " s" << (tarjan_sizes == expected ? "" : " MISMATCH") << endl;
+  cout << "parallel: " << parallel_time << " s (" << threads << " threads)"
+       << (parallel_sizes == expected ? "" : " MISMATCH") << endl;
+}
+
+/*
+ * Function: scalingBenchmark
+ * Usage: scalingBenchmark(graph, rgraph, max_threads);
+ * ----------------------------------------------------
+ * Runs the parallel engine with 1, 2, 4, ... max_threads threads and
+ * prints the time of each run, its speedup over tarjan and whether its
+ * SCC sizes agree with those of tarjan.
+ */
+void scalingBenchmark(CsrGraph & graph, CsrGraph & rgraph, int max_threads) {
+  typedef chrono::steady_clock Clock;
+  cout << "nodes: " << graph.offsets.size() - 1 << " edges: " << graph.targets.size() << endl;
+  vector<int> expected;
+  Clock::time_point start = Clock::now();
+  tarjan(graph, expected);
+  double tarjan_time = chrono::duration<double>(Clock::now() - start).count();
+  sort(expected.begin(), expected.end());
+  cout << "tarjan: " << tarjan_time << " s" << endl;
+  for (int threads = 1; ; threads = min(threads * 2, max_threads)) {
+    vector<int> sizes;
+    start = Clock::now();
+    parallelScc(graph, rgraph, sizes, threads);
+    double time = chrono::duration<double>(Clock::now() - start).count();
+    sort(sizes.begin(), sizes.end());
+    cout << threads << " threads: " << time << " s, speedup " << tarjan_time / time
+	 << (sizes == expected ? "" : " MISMATCH") << endl;
+    if (threads == max_threads) break;
+  }
+}
+
 /*
  * Function: readFile
  * Usage: map<int, multiset> graph; readFile(graph);
@@ -142,6 +1104,192 @@ void readFile(map<int, set<int> > & graph, map<int, set<int> > & rgraph, ifstrea
   infile.close();
 }
 
+/*
+ * Function: readSnapshot
+ * Usage: readSnapshot(graph, rgraph, filename);
+ * ---------------------------------------------
+ * Fills the graph and the reverse graph from a graph snapshot instead of
+ * a text file. Returns false if the file is not a valid snapshot.
+ */
+bool readSnapshot(map<int, set<int> > & graph, map<int, set<int> > & rgraph, string filename) {
+  GraphSnapshot snapshot;
+  if (!openSnapshot(snapshot, filename)) return false;
+  for (long long v = 0; v < snapshot.nodes; v++) {
+    for (long long e = snapshot.offsets[v]; e < snapshot.offsets[v + 1]; e++) {
+      graph[v].insert(snapshot.targets[e]);
+      rgraph[snapshot.targets[e]].insert(v);
+    }
+  }
+  closeSnapshot(snapshot);
+  return true;
+}
+
+/*
+ * Function: readFile
+ * Usage: CsrGraph graph, rgraph; readFile(graph, &rgraph, filename);
+ * ------------------------------------------------------------------
+ * Reads the same edge file into a CSR graph and, unless rgraph is NULL,
+ * its reverse. The file is
+ * mapped into memory and scanned twice: the first pass counts the out-
+ * and in-degree of every node, which gives the offsets of both graphs,
+ * and the second pass writes every edge into both graphs. Besides the
+ * graphs no memory is needed. Graph snapshots are loaded directly and
+ * only the reverse graph is built. Returns false if the file cannot be
+ * read or is a snapshot with more nodes or edges than fit in an int.
+ */
+bool readFile(CsrGraph & graph, CsrGraph * rgraph, string filename) {
+  if (isSnapshot(filename)) {
+    GraphSnapshot snapshot;
+    if (!openSnapshot(snapshot, filename)) return false;
+    if (!snapshotFitsInt(snapshot)) {
+      closeSnapshot(snapshot);
+      return false;
+    }
+    graph.offsets.assign(snapshot.offsets, snapshot.offsets + snapshot.nodes + 1);
+    graph.targets.assign(snapshot.targets, snapshot.targets + snapshot.edges);
+    closeSnapshot(snapshot);
+    if (rgraph != NULL) reverseGraph(graph, *rgraph);
+    return true;
+  }
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) < 0) {
+    close(fd);
+    return false;
+  }
+  size_t size = file_stat.st_size;
+  const char * data = NULL;
+  if (size > 0) {
+    void * mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    data = (const char *) mapped;
+    madvise(mapped, size, MADV_SEQUENTIAL);
+  }
+  close(fd);
+  vector<int> degrees, rdegrees;
+  if (!countEdges(data, data + size, degrees, rdegrees, NULL, NULL)) {
+    if (size > 0) munmap((void *) data, size);
+    return false;
+  }
+  int graph_size = degrees.size();
+  graph.offsets.assign(graph_size + 1, 0);
+  for (int v = 0; v < graph_size; v++) graph.offsets[v + 1] = graph.offsets[v] + degrees[v];
+  graph.targets.resize(graph.offsets[graph_size]);
+  // reuse the degree vectors as the next free slot of every node
+  degrees.assign(graph.offsets.begin(), graph.offsets.end() - 1);
+  if (rgraph != NULL) {
+    rgraph -> offsets.assign(graph_size + 1, 0);
+    for (int v = 0; v < graph_size; v++) rgraph -> offsets[v + 1] = rgraph -> offsets[v] + rdegrees[v];
+    rgraph -> targets.resize(rgraph -> offsets[graph_size]);
+    rdegrees.assign(rgraph -> offsets.begin(), rgraph -> offsets.end() - 1);
+  }
+  countEdges(data, data + size, degrees, rdegrees, &graph, rgraph);
+  if (size > 0) munmap((void *) data, size);
+  return true;
+}
+
+/*
+ * Function: countEdges
+ * Usage: countEdges(begin, end, degrees, rdegrees, NULL, NULL);
+ * -------------------------------------------------------------
+ * Scans the rows "tail head [head ...]" between p and end. Without graphs
+ * it counts the out- and in-degree of every node, growing the degree
+ * vectors to the largest node number. With graphs, degrees and rdegrees
+ * hold the next free slot of every node and each edge is written into
+ * graph and, unless rgraph is NULL, into rgraph. Numbers are separated
+ * by blanks; a negative, malformed or too large number makes the first
+ * pass report its line and return false.
+ */
+bool countEdges(const char * p, const char * end, vector<int> & degrees, vector<int> & rdegrees, CsrGraph * graph, CsrGraph * rgraph) {
+  long line = 1;
+  while (p < end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    if (p == end) break;
+    if (*p == '\n') { // empty line
+      p++;
+      line++;
+      continue;
+    }
+    int tail;
+    p = parseInteger(p, end, tail);
+    bool valid = tail >= 0;
+    while (valid && p < end && *p != '\n') {
+      if (*p == ' ' || *p == '\t' || *p == '\r') { // separator
+	p++;
+	continue;
+      }
+      int head;
+      p = parseInteger(p, end, head);
+      valid = head >= 0;
+      if (!valid) break;
+      if (graph == NULL) {
+	int needed = max(tail, head) + 1;
+	if ((int) degrees.size() < needed) {
+	  degrees.resize(needed, 0);
+	  rdegrees.resize(needed, 0);
+	}
+	degrees[tail]++;
+	rdegrees[head]++;
+      } else {
+	graph -> targets[degrees[tail]++] = head;
+	if (rgraph != NULL) rgraph -> targets[rdegrees[head]++] = tail;
+      }
+    }
+    if (!valid) {
+      cerr << "Negative, malformed or too large number in line " << line << endl;
+      return false;
+    }
+    p++; // the newline
+    line++;
+  }
+  return true;
+}
+
+/*
+ * Function: parseInteger
+ * ----------------------
+ * Reads the decimal digits starting at p into value and returns the
+ * position after the last digit. value is -1 if there is no digit at p
+ * or the number is INT_MAX or more, too large for a node number.
+ */
+const char * parseInteger(const char * p, const char * end, int & value) {
+  if (p == end || *p < '0' || *p > '9') {
+    value = -1;
+    return p;
+  }
+  long long result = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    if (result < INT_MAX) result = result * 10 + (*p - '0');
+    p++;
+  }
+  value = result < INT_MAX ? result : -1;
+  return p;
+}
+
+/*
+ * Function: reverseGraph
+ * Usage: reverseGraph(graph, rgraph);
+ * -----------------------------------
+ * Builds the reverse of a CSR graph with a counting sort by head.
+ */
+void reverseGraph(CsrGraph & graph, CsrGraph & rgraph) {
+  int graph_size = graph.offsets.size() - 1;
+  rgraph.offsets.assign(graph_size + 1, 0);
+  for (size_t e = 0; e < graph.targets.size(); e++) rgraph.offsets[graph.targets[e] + 1]++;
+  for (int v = 0; v < graph_size; v++) rgraph.offsets[v + 1] += rgraph.offsets[v];
+  vector<int> next(rgraph.offsets.begin(), rgraph.offsets.end() - 1);
+  rgraph.targets.resize(graph.targets.size());
+  for (int v = 0; v < graph_size; v++) {
+    for (int e = graph.offsets[v]; e < graph.offsets[v + 1]; e++) {
+      rgraph.targets[next[graph.targets[e]]++] = v;
+    }
+  }
+}
+
 /*
  * Function: print
  * Usage: vector<int> vec; print(vec);
@@ -172,18 +1320,50 @@ void print_biggest(map<int, set<int> > & scc) {
   for (MapIt it = scc.begin(); it != scc.end(); ++it) {
     mvector.push_back(it -> second.size());
   }
-  sort(mvector.begin(), mvector.end());
-  for (int i = 0; i < 5; i++) {
-    if (!mvector.empty()) {
-      cout << mvector.back() << ",";
-      mvector.pop_back();
-    } else {
-      cout << 0 << ",";
-    }
+  print_biggest(mvector);
+}
+
+/*
+ * Function: print_biggest
+ * Usage: vector<int> sizes; print_biggest(sizes, k);
+ * --------------------------------------------------
+ * Prints the k largest SCC sizes (default five) in decreasing order,
+ * padded with zeros if there are fewer than k SCCs.
+ */
+void print_biggest(vector<int> & sizes, int k) {
+  vector<int> top;
+  biggest(sizes, k, top);
+  for (int i = 0; i < k; i++) {
+    cout << (i < (int) top.size() ? top[i] : 0) << ",";
   }
   cout << endl;
 }
 
+/*
+ * Function: biggest
+ * Usage: vector<int> top; biggest(sizes, k, top);
+ * -----------------------------------------------
+ * Selects the k largest values of sizes in decreasing order. The values
+ * stream through a min-heap that keeps the k largest seen so far, which
+ * takes O(n log k) time and O(k) extra memory.
+ */
+void biggest(vector<int> & sizes, int k, vector<int> & top) {
+  priority_queue<int, vector<int>, greater<int> > heap;
+  for (size_t i = 0; i < sizes.size() && k > 0; i++) {
+    if ((int) heap.size() < k) {
+      heap.push(sizes[i]);
+    } else if (sizes[i] > heap.top()) {
+      heap.pop();
+      heap.push(sizes[i]);
+    }
+  }
+  top.resize(heap.size());
+  for (int i = top.size() - 1; i >= 0; i--) {
+    top[i] = heap.top();
+    heap.pop();
+  }
+}
+
 
 /*
  * Function: promptUserForFile
@@ -212,3 +1392,14 @@ bool testFileName(ifstream & infile, string filename) {
   infile.open(filename.c_str());
   return !infile.fail();
 }
+
+int stringToInteger(string str) {
+  istringstream stream(str);
+  int value;
+  stream >> value;
+  if (stream.fail() || !(stream >> ws).eof()) {
+    cerr << "stringToInteger: Illegal integer format (" + str + ")";
+    return 1;
+  }
+  return value;
+}
@@ -0,0 +1,236 @@
+/*
+ * File: GraphSnapshot.h
+ * ---------------------
+ * A binary graph snapshot shared by the dijkstra, scc and contract
+ * programs. The snapshot holds a graph in compressed sparse row form and
+ * is written once by MakeSnapshot from any of the text formats. The
+ * programs map it into memory at startup instead of parsing text; they
+ * recognize a snapshot by its magic bytes, so a snapshot can be given
+ * wherever a text graph file is expected.
+ *
+ * File layout (native byte order, every section 8 byte aligned):
+ *   header   SNAPSHOT_MAGIC, version, flags, node count, edge count
+ *   offsets  long long[nodes + 1]  the edges of node v are the slots
+ *                                  offsets[v] to offsets[v + 1] - 1
+ *   targets  int[edges]            the head of every edge
+ *   weights  int[edges]            edge lengths, if SNAPSHOT_WEIGHTED
+ *   present  unsigned char[nodes]  1 for every node that had its own row
+ *                                  in the text file
+ * Nodes are numbered as in the text file, so node 0 is usually unused.
+ */
+
+#ifndef _GraphSnapshot_h
+#define _GraphSnapshot_h
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+const char SNAPSHOT_MAGIC[8] = {'G', 'R', 'A', 'P', 'H', 'S', 'N', 'P'};
+const int SNAPSHOT_VERSION = 1;
+const int SNAPSHOT_WEIGHTED = 1; // flag: the weights section is present
+
+/*
+ * Type: SnapshotHeader
+ * --------------------
+ * The first bytes of a snapshot file.
+ */
+struct SnapshotHeader {
+  char magic[8];
+  int version;
+  int flags;
+  long long nodes;
+  long long edges;
+};
+
+/*
+ * Type: GraphSnapshot
+ * -------------------
+ * A snapshot mapped into memory. The arrays point into the mapping and
+ * stay valid until closeSnapshot; weights is NULL for unweighted graphs.
+ */
+struct GraphSnapshot {
+  long long nodes;
+  long long edges;
+  const long long * offsets;
+  const int * targets;
+  const int * weights;
+  const unsigned char * present;
+  void * mapped;
+  size_t size;
+};
+
+inline bool validSnapshot(const GraphSnapshot & snapshot);
+inline void closeSnapshot(GraphSnapshot & snapshot);
+
+/*
+ * Function: snapshotAlign
+ * -----------------------
+ * Rounds a section size up to the next multiple of 8 bytes.
+ */
+inline size_t snapshotAlign(size_t size) {
+  return (size + 7) & ~(size_t) 7;
+}
+
+/*
+ * Function: isSnapshot
+ * Usage: if (isSnapshot(filename)) ...
+ * ------------------------------------
+ * Returns true if the file starts with the snapshot magic bytes.
+ */
+inline bool isSnapshot(std::string filename) {
+  FILE * file = fopen(filename.c_str(), "rb");
+  if (file == NULL) return false;
+  char magic[sizeof SNAPSHOT_MAGIC];
+  bool result = fread(magic, 1, sizeof magic, file) == sizeof magic
+    && memcmp(magic, SNAPSHOT_MAGIC, sizeof magic) == 0;
+  fclose(file);
+  return result;
+}
+
+/*
+ * Function: openSnapshot
+ * Usage: GraphSnapshot snapshot; openSnapshot(snapshot, filename);
+ * ----------------------------------------------------------------
+ * Maps a snapshot file into memory and points the arrays of snapshot at
+ * its sections. Returns false if the file is not a snapshot of this
+ * version, is shorter than its header says or fails validSnapshot.
+ */
+inline bool openSnapshot(GraphSnapshot & snapshot, std::string filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) < 0 || (size_t) file_stat.st_size < sizeof(SnapshotHeader)) {
+    close(fd);
+    return false;
+  }
+  size_t size = file_stat.st_size;
+  void * mapped = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) return false;
+  const SnapshotHeader * header = (const SnapshotHeader *) mapped;
+  const char * data = (const char *) mapped;
+  if (header -> nodes < 0 || header -> edges < 0
+      || (unsigned long long) header -> nodes >= size / sizeof(long long)
+      || (unsigned long long) header -> edges > size / sizeof(int)) {
+    munmap(mapped, size); // the section sizes below could overflow
+    return false;
+  }
+  size_t offsets_size = snapshotAlign((header -> nodes + 1) * sizeof(long long));
+  size_t targets_size = snapshotAlign(header -> edges * sizeof(int));
+  size_t weights_size = header -> flags & SNAPSHOT_WEIGHTED ? targets_size : 0;
+  size_t present_size = snapshotAlign(header -> nodes);
+  if (memcmp(header -> magic, SNAPSHOT_MAGIC, sizeof SNAPSHOT_MAGIC) != 0
+      || header -> version != SNAPSHOT_VERSION
+      || size < sizeof(SnapshotHeader) + offsets_size + targets_size + weights_size + present_size) {
+    munmap(mapped, size);
+    return false;
+  }
+  snapshot.nodes = header -> nodes;
+  snapshot.edges = header -> edges;
+  data += sizeof(SnapshotHeader);
+  snapshot.offsets = (const long long *) data;
+  data += offsets_size;
+  snapshot.targets = (const int *) data;
+  data += targets_size;
+  snapshot.weights = weights_size > 0 ? (const int *) data : NULL;
+  data += weights_size;
+  snapshot.present = (const unsigned char *) data;
+  snapshot.mapped = mapped;
+  snapshot.size = size;
+  if (!validSnapshot(snapshot)) {
+    closeSnapshot(snapshot);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Function: validSnapshot
+ * Usage: if (!validSnapshot(snapshot)) ...
+ * ----------------------------------------
+ * Checks once, when the snapshot is opened, that the readers can index
+ * it without further tests: the offsets start at 0, never decrease and
+ * end at the edge count, and every target is a node of the graph.
+ */
+inline bool validSnapshot(const GraphSnapshot & snapshot) {
+  if (snapshot.offsets[0] != 0 || snapshot.offsets[snapshot.nodes] != snapshot.edges) return false;
+  for (long long node = 0; node < snapshot.nodes; node++) {
+    if (snapshot.offsets[node + 1] < snapshot.offsets[node]) return false;
+  }
+  for (long long i = 0; i < snapshot.edges; i++) {
+    if (snapshot.targets[i] < 0 || snapshot.targets[i] >= snapshot.nodes) return false;
+  }
+  return true;
+}
+
+/*
+ * Function: snapshotFitsInt
+ * Usage: if (!snapshotFitsInt(snapshot)) ...
+ * ------------------------------------------
+ * Returns true if the node and edge counts, and with them all offsets,
+ * fit into the int vectors of the CSR graphs the programs copy a
+ * snapshot into. validSnapshot allows larger graphs.
+ */
+inline bool snapshotFitsInt(const GraphSnapshot & snapshot) {
+  return snapshot.nodes < INT_MAX && snapshot.edges <= INT_MAX;
+}
+
+/*
+ * Function: closeSnapshot
+ * Usage: closeSnapshot(snapshot);
+ * -------------------------------
+ * Unmaps a snapshot opened with openSnapshot.
+ */
+inline void closeSnapshot(GraphSnapshot & snapshot) {
+  munmap(snapshot.mapped, snapshot.size);
+  snapshot.mapped = NULL;
+}
+
+/*
+ * Function: writeSection
+ * ----------------------
+ * Writes size bytes followed by the zero padding up to the next multiple
+ * of 8 bytes.
+ */
+inline bool writeSection(FILE * file, const void * data, size_t size) {
+  static const char padding[8] = {0};
+  if (size > 0 && fwrite(data, 1, size, file) != size) return false;
+  size_t pad = snapshotAlign(size) - size;
+  return pad == 0 || fwrite(padding, 1, pad, file) == pad;
+}
+
+/*
+ * Function: writeSnapshot
+ * Usage: writeSnapshot(filename, offsets, targets, weights, present);
+ * -------------------------------------------------------------------
+ * Writes a graph in CSR form to a snapshot file. offsets has one entry
+ * more than present; weights is either empty (unweighted graph) or has
+ * one entry per target. Returns false if the file cannot be written.
+ */
+inline bool writeSnapshot(std::string filename, const std::vector<long long> & offsets,
+			  const std::vector<int> & targets, const std::vector<int> & weights,
+			  const std::vector<unsigned char> & present) {
+  FILE * file = fopen(filename.c_str(), "wb");
+  if (file == NULL) return false;
+  SnapshotHeader header;
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof SNAPSHOT_MAGIC);
+  header.version = SNAPSHOT_VERSION;
+  header.flags = weights.empty() ? 0 : SNAPSHOT_WEIGHTED;
+  header.nodes = present.size();
+  header.edges = targets.size();
+  bool ok = writeSection(file, &header, sizeof header)
+    && writeSection(file, &offsets[0], offsets.size() * sizeof(long long))
+    && writeSection(file, targets.empty() ? NULL : &targets[0], targets.size() * sizeof(int))
+    && (weights.empty() || writeSection(file, &weights[0], weights.size() * sizeof(int)))
+    && writeSection(file, present.empty() ? NULL : &present[0], present.size());
+  return fclose(file) == 0 && ok;
+}
+
+#endif
@@ -0,0 +1,178 @@
+/*
+ * File: MakeSnapshot.cpp
+ * ----------------------
+ * This program converts a graph from one of the text formats used in
+ * this repository into a binary graph snapshot (see GraphSnapshot.h).
+ * Every row of the text file starts with a node number followed by the
+ * heads of edges leaving it, either as plain node numbers or as
+ * node,length pairs. This covers all three formats:
+ *   dijkstra  "1 2,10 3,20"  adjacency list with edge lengths
+ *   scc       "1 2"          one edge per row, rows may repeat a node
+ *   contract  "1 2 3 4"      adjacency list of an undirected graph
+ * The snapshot stores edge lengths if any row contains one; edges
+ * without a length are then skipped like malformed numbers.
+ * Usage: MakeSnapshot INPUT OUTPUT
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "GraphSnapshot.h"
+using namespace std;
+
+/* Function prototypes */
+
+long long readFile(ifstream & infile, vector<long long> & offsets, vector<int> & targets,
+		   vector<int> & weights, vector<unsigned char> & present);
+const char * parseInteger(const char * p, int & value);
+bool isSeparator(char c);
+
+const int MAX_NODE = INT_MAX - 1; // the node count must fit into an int
+
+/* Main program */
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    cerr << "Usage: " << argv[0] << " INPUT OUTPUT" << endl;
+    return 1;
+  }
+  ifstream infile(argv[1]);
+  if (infile.fail()) {
+    cerr << "No such file: " << argv[1] << endl;
+    return 1;
+  }
+  vector<long long> offsets;
+  vector<int> targets, weights;
+  vector<unsigned char> present;
+  long long skipped = readFile(infile, offsets, targets, weights, present);
+  if (skipped > 0) {
+    cout << "Warning: malformed number or edge without length (" << skipped << " times)" << endl;
+  }
+  if (!writeSnapshot(argv[2], offsets, targets, weights, present)) {
+    cerr << "Unable to write " << argv[2] << endl;
+    return 1;
+  }
+  cout << "nodes: " << present.size() << " edges: " << targets.size()
+       << (weights.empty() ? " unweighted" : " weighted") << endl;
+  return 0;
+}
+
+/*
+ * Function: readFile
+ * ------------------
+ * Reads the rows of the text file into a list of edges and sorts them
+ * into CSR form by source node with a counting sort, keeping the order
+ * of the edges of each node. The numbers are checked like the parser of
+ * dijkstra/DijkstraHeap.cpp does: rows with a malformed node number and
+ * edges with a malformed target or length (a minus sign, other
+ * characters than digits or a number too large) are skipped, and so are
+ * edges without a length if other edges have one. Returns the number of
+ * skipped rows and edges.
+ */
+long long readFile(ifstream & infile, vector<long long> & offsets, vector<int> & targets,
+		   vector<int> & weights, vector<unsigned char> & present) {
+  vector<int> sources, heads, lengths; // length -1: the edge had none
+  vector<int> rows; // the node number of every row
+  bool weighted = false;
+  int max_node = -1;
+  long long skipped = 0;
+  string line;
+  while (getline(infile, line)) {
+    const char * p = line.c_str();
+    while (isSeparator(*p)) p++;
+    if (*p == '\0') continue; // empty row
+    int node;
+    p = parseInteger(p, node);
+    if (node < 0 || node > MAX_NODE || !(*p == '\0' || isSeparator(*p))) {
+      skipped++;
+      continue;
+    }
+    rows.push_back(node);
+    max_node = max(max_node, node);
+    while (*p != '\0') {
+      if (isSeparator(*p)) {
+	p++;
+	continue;
+      }
+      int target_node, edge_length = -1;
+      p = parseInteger(p, target_node);
+      bool has_length = target_node >= 0 && *p == ',';
+      if (has_length) p = parseInteger(p + 1, edge_length);
+      if (target_node < 0 || target_node > MAX_NODE || (has_length && edge_length < 0) ||
+	  !(*p == '\0' || isSeparator(*p))) {
+	while (*p != '\0' && !isSeparator(*p)) p++;
+	skipped++;
+	continue;
+      }
+      weighted = weighted || has_length;
+      sources.push_back(node);
+      heads.push_back(target_node);
+      lengths.push_back(edge_length);
+      max_node = max(max_node, target_node);
+    }
+  }
+  if (weighted) { // drop the edges without a length
+    size_t kept = 0;
+    for (size_t i = 0; i < sources.size(); i++) {
+      if (lengths[i] < 0) {
+	skipped++;
+	continue;
+      }
+      sources[kept] = sources[i];
+      heads[kept] = heads[i];
+      lengths[kept] = lengths[i];
+      kept++;
+    }
+    sources.resize(kept);
+    heads.resize(kept);
+    lengths.resize(kept);
+  }
+  int graph_size = max_node + 1;
+  present.assign(graph_size, 0);
+  for (size_t i = 0; i < rows.size(); i++) present[rows[i]] = 1;
+  offsets.assign(graph_size + 1, 0);
+  for (size_t i = 0; i < sources.size(); i++) offsets[sources[i] + 1]++;
+  for (int v = 0; v < graph_size; v++) offsets[v + 1] += offsets[v];
+  vector<long long> next(offsets.begin(), offsets.end() - 1); // next free slot per node
+  targets.resize(heads.size());
+  if (weighted) weights.resize(heads.size());
+  for (size_t i = 0; i < sources.size(); i++) {
+    long long slot = next[sources[i]]++;
+    targets[slot] = heads[i];
+    if (weighted) weights[slot] = lengths[i];
+  }
+  return skipped;
+}
+
+/*
+ * Function: parseInteger
+ * ----------------------
+ * Reads the decimal digits starting at p into value and returns the
+ * position after the last digit. value is -1 if there is no digit at p
+ * or the number does not fit into an int.
+ */
+const char * parseInteger(const char * p, int & value) {
+  if (*p < '0' || *p > '9') {
+    value = -1;
+    return p;
+  }
+  long long result = 0;
+  while (*p >= '0' && *p <= '9') {
+    if (result <= INT_MAX) result = result * 10 + (*p - '0');
+    p++;
+  }
+  value = result <= INT_MAX ? result : -1;
+  return p;
+}
+
+/*
+ * Function: isSeparator
+ * ---------------------
+ * Returns true for the characters between the numbers of a row.
+ */
+bool isSeparator(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}